@@ -0,0 +1,247 @@
+#include <benchmark/benchmark.h>
+
+#include <memory_resource>
+
+#include <Geometry/Shapes2D/circle.h>
+#include <Geometry/Shapes2D/rectangle.h>
+#include <Geometry/Shapes3D/cuboid.h>
+#include <Geometry/Shapes3D/cylinder.h>
+#include <Geometry/Shapes3D/cone.h>
+#include <Geometry/cartesian_cs_3d.h>
+#include <Geometry/anchored_shape.h>
+#include <Geometry/padded_shape.h>
+#include <Geometry/point_batch.h>
+#include <Geometry/transformations.h>
+
+using namespace geo;
+
+namespace {
+
+  const Eigen::Matrix<float, 3, 1> AXIS {Eigen::Matrix<float, 3, 1>(1, 2, 3).normalized()};
+
+
+  /**
+    * Construction
+    */
+  template <typename SHAPE>
+  void roundConstruction(benchmark::State& state) {
+    size_t num_vertices = state.range(0);
+    for(auto _ : state){
+      SHAPE shape(1.0f, 2.0f, Point<float, 3>(), num_vertices);
+      benchmark::DoNotOptimize(shape.data());
+    }
+    state.SetItemsProcessed(state.iterations() * num_vertices);
+  }
+
+  void BM_CircleConstruction(benchmark::State& state) {
+    size_t num_vertices = state.range(0);
+    for(auto _ : state){
+      Circle<float> circle(1.0f, Point<float, 3>(), num_vertices);
+      benchmark::DoNotOptimize(circle.data());
+    }
+    state.SetItemsProcessed(state.iterations() * num_vertices);
+  }
+
+  void BM_CylinderConstruction(benchmark::State& state) { roundConstruction<Cylinder<float>>(state); }
+  void BM_ConeConstruction(benchmark::State& state) { roundConstruction<Cone<float>>(state); }
+
+  // Per-frame arena: released once per iteration instead of freeing every shape
+  void BM_CylinderConstructionArena(benchmark::State& state) {
+    size_t num_vertices = state.range(0);
+    std::vector<std::byte> buffer(1 << 20);
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+    for(auto _ : state){
+      Cylinder<float> cylinder(1.0f, 2.0f, Point<float, 3>(), num_vertices, &arena);
+      benchmark::DoNotOptimize(cylinder.data());
+      arena.release();
+    }
+    state.SetItemsProcessed(state.iterations() * num_vertices);
+  }
+
+  // Streaming into a reused staging buffer, without building the shape
+  void BM_CylinderGenerate(benchmark::State& state) {
+    size_t num_vertices = state.range(0);
+    std::vector<float> vertices(3 * 2 * num_vertices);
+    std::vector<float> normals(vertices.size());
+    for(auto _ : state){
+      Cylinder<float>::generate(1.0f, 2.0f, Point<float, 3>(), num_vertices, PackedOutput<float>(vertices.data()), PackedOutput<float>(normals.data()));
+      benchmark::DoNotOptimize(vertices.data());
+      benchmark::DoNotOptimize(normals.data());
+    }
+    state.SetItemsProcessed(state.iterations() * num_vertices);
+  }
+
+  void BM_RectangleConstruction(benchmark::State& state) {
+    for(auto _ : state){
+      Rectangle<float> rectangle(1.0f, 2.0f, Point<float, 3>(1, 2, 3));
+      benchmark::DoNotOptimize(rectangle.data());
+    }
+  }
+
+  void BM_CuboidConstruction(benchmark::State& state) {
+    for(auto _ : state){
+      Cuboid<float> cuboid(1.0f, 2.0f, 3.0f, Point<float, 3>(1, 2, 3));
+      benchmark::DoNotOptimize(cuboid.data());
+    }
+  }
+
+
+  /**
+    * Transformations, over the number of vertices of a cylinder
+    */
+  void BM_Scale3D(benchmark::State& state) {
+    Cylinder<float> cylinder(1.0f, 2.0f, Point<float, 3>(), state.range(0) / 2);
+    for(auto _ : state){
+      cylinder.scale3D(1.0f, 1.0f, 1.0f);
+      benchmark::DoNotOptimize(cylinder.data());
+    }
+    state.SetItemsProcessed(state.iterations() * cylinder.size());
+  }
+
+  void BM_Rotate3D(benchmark::State& state) {
+    Cylinder<float> cylinder(1.0f, 2.0f, Point<float, 3>(), state.range(0) / 2);
+    for(auto _ : state){
+      cylinder.rotate3D(0.01f, AXIS);
+      benchmark::DoNotOptimize(cylinder.data());
+    }
+    state.SetItemsProcessed(state.iterations() * cylinder.size());
+  }
+
+  void BM_Rotate3DPadded(benchmark::State& state) {
+    PaddedShape<float> cylinder(Cylinder<float>(1.0f, 2.0f, Point<float, 3>(), state.range(0) / 2));
+    for(auto _ : state){
+      cylinder.rotate3D(0.01f, AXIS);
+      benchmark::DoNotOptimize(cylinder.data());
+    }
+    state.SetItemsProcessed(state.iterations() * cylinder.size());
+  }
+
+
+  /**
+    * Distance queries over a point cloud: interleaved points and points packed in batches
+    */
+  std::vector<Point<float, 3>> pointCloud(size_t num_points) {
+    std::vector<Point<float, 3>> points(num_points);
+    for(size_t i = 0; i < num_points; i++)
+      points[i] = Point<float, 3>(std::sin(0.1f * i), std::cos(0.3f * i), 0.001f * i);
+    return points;
+  }
+
+  void BM_SquaredDistances(benchmark::State& state) {
+    std::vector<Point<float, 3>> points = pointCloud(state.range(0));
+    std::vector<float> distances(points.size());
+    for(auto _ : state){
+      squaredDistances(points.data(), points.size(), AXIS, distances.data());
+      benchmark::DoNotOptimize(distances.data());
+    }
+    state.SetItemsProcessed(state.iterations() * points.size());
+  }
+
+  void BM_SquaredDistancesBatches(benchmark::State& state) {
+    std::vector<Point<float, 3>> points = pointCloud(state.range(0));
+    std::vector<PointBatch<float, 3, 8>> batches;
+    toBatches(points.data(), points.size(), batches);
+    std::vector<float> distances(points.size());
+    for(auto _ : state){
+      squaredDistances(batches.data(), points.size(), AXIS, distances.data());
+      benchmark::DoNotOptimize(distances.data());
+    }
+    state.SetItemsProcessed(state.iterations() * points.size());
+  }
+
+
+  /**
+    * Coordinate systems
+    */
+  void BM_CartesianCSConstruction(benchmark::State& state) {
+    Eigen::Matrix<float, 3, 1> center(1, 2, 3);
+    Eigen::Matrix<float, 3, 1> axis_1(1, 1, 0);
+    Eigen::Matrix<float, 3, 1> axis_2(-1, 1, 0);
+    for(auto _ : state){
+      CartesianCS_3D<float> cs(center, axis_1, axis_2);
+      benchmark::DoNotOptimize(cs.transformMatrix().data());
+    }
+  }
+
+  void BM_LookAt(benchmark::State& state) {
+    Eigen::Matrix<float, 3, 1> position(10, 5, 3);
+    Eigen::Matrix<float, 3, 1> look_at(0, 0, 0);
+    Eigen::Matrix<float, 3, 1> vertical(0, 0, 1);
+    for(auto _ : state){
+      Eigen::Matrix<float, 4, 4> view = CartesianCS_3D<float>::transformMatrix(position, look_at, vertical);
+      benchmark::DoNotOptimize(view.data());
+    }
+  }
+
+  /**
+    * Vertices of a shape far from the origin to the CS of a camera: all in double, and anchored (double anchor, float vertices)
+    */
+  const Eigen::Matrix<double, 3, 1> FAR_CENTER {1e7, -3e6, 5e5};
+
+  void BM_ToLocalDouble(benchmark::State& state) {
+    Cylinder<double> cylinder(1.0, 2.0, Point<double, 3>(FAR_CENTER.x(), FAR_CENTER.y(), FAR_CENTER.z()), state.range(0) / 2);
+    CartesianCS_3D<double> camera(FAR_CENTER, Eigen::Matrix<double, 3, 1>(1, 1, 0), Eigen::Matrix<double, 3, 1>(-1, 1, 0));
+    std::vector<Point<double, 3>> out(cylinder.size());
+    for(auto _ : state){
+      camera.toLocal(cylinder.vertices().data(), cylinder.vertices().data() + cylinder.size(), out.data());
+      benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * cylinder.size());
+  }
+
+  void BM_ToLocalAnchored(benchmark::State& state) {
+    AnchoredShape<float, double> cylinder(Cylinder<double>(1.0, 2.0, Point<double, 3>(FAR_CENTER.x(), FAR_CENTER.y(), FAR_CENTER.z()), state.range(0) / 2));
+    CartesianCS_3D<double> camera(FAR_CENTER, Eigen::Matrix<double, 3, 1>(1, 1, 0), Eigen::Matrix<double, 3, 1>(-1, 1, 0));
+    std::vector<Point<float, 3>> out(cylinder.size());
+    for(auto _ : state){
+      cylinder.toLocal(camera, out.data());
+      benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * cylinder.size());
+  }
+
+
+  /**
+    * Projections
+    */
+  void BM_PerspectiveProjection(benchmark::State& state) {
+    for(auto _ : state){
+      Eigen::Matrix<float, 4, 4> projection = perspectiveProjection(1.0f, 1.5f, 0.1f, 100.0f);
+      benchmark::DoNotOptimize(projection.data());
+    }
+  }
+
+  void BM_OrthoProjection(benchmark::State& state) {
+    for(auto _ : state){
+      Eigen::Matrix<float, 4, 4> projection = orthoProjection(-1.0f, 1.0f, -1.0f, 1.0f, 0.1f, 100.0f);
+      benchmark::DoNotOptimize(projection.data());
+    }
+  }
+
+} // namespace
+
+
+BENCHMARK(BM_CircleConstruction)->RangeMultiplier(4)->Range(8, 2048);
+BENCHMARK(BM_CylinderConstruction)->RangeMultiplier(4)->Range(8, 2048);
+BENCHMARK(BM_ConeConstruction)->RangeMultiplier(4)->Range(8, 2048);
+BENCHMARK(BM_CylinderConstructionArena)->RangeMultiplier(4)->Range(8, 2048);
+BENCHMARK(BM_CylinderGenerate)->RangeMultiplier(4)->Range(8, 2048);
+BENCHMARK(BM_RectangleConstruction);
+BENCHMARK(BM_CuboidConstruction);
+
+BENCHMARK(BM_Scale3D)->RangeMultiplier(8)->Range(64, 1 << 18);
+BENCHMARK(BM_Rotate3D)->RangeMultiplier(8)->Range(64, 1 << 18);
+BENCHMARK(BM_Rotate3DPadded)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+BENCHMARK(BM_SquaredDistances)->RangeMultiplier(16)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_SquaredDistancesBatches)->RangeMultiplier(16)->Range(1 << 10, 1 << 20);
+
+BENCHMARK(BM_CartesianCSConstruction);
+BENCHMARK(BM_LookAt);
+BENCHMARK(BM_ToLocalDouble)->RangeMultiplier(8)->Range(64, 1 << 18);
+BENCHMARK(BM_ToLocalAnchored)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+BENCHMARK(BM_PerspectiveProjection);
+BENCHMARK(BM_OrthoProjection);
+
+BENCHMARK_MAIN();
@@ -1,92 +1,151 @@
-#ifndef CIRCLE_H
-#define CIRCLE_H
-
-#include <cmath>
-
-#include "../constants.h"
-#include "../shape.h"
-
-#define DEF_RADIUS 1
-#define DEF_NUM_VERTICES 36
-
-namespace geo {
-
-  /** CLASS Circle
-    * Template params:
-    *                 T --> type used for the coordinates
-    * A circle is a 2D figure. Additional dimensions will be completed with coordinate value 0.0
-    * The circle is centered at the origin
-    * Parameters:
-    *            - radius (default = 1)
-    *            - num_vertices (default = 36, 1 vertex per 10)
-    */
-
-  template <typename T = float>
-  class Circle : public Shape<T, 3>{
-  protected:
-    T _radius;
-    Point<T, 3> _center;
-
-  public:
-    Circle() : Circle(DEF_RADIUS, Point<T, 3>(), DEF_NUM_VERTICES) {}
-
-    Circle(T radius) : Circle(radius, Point<T, 3>(), DEF_NUM_VERTICES) {}
-
-    Circle(T radius, size_t num_vertices) : Circle(radius, Point<T, 3>(), num_vertices) {}
-
-    Circle(T radius, Point<T, 3> center, size_t num_vertices = DEF_NUM_VERTICES) : _radius{radius}, _center{center} {
-      this->_vertices.resize(num_vertices);
-      this->_normals.resize(this->_vertices.size());
-
-      // Calculate the vertices starting from (+radius,0)
-      T delta_angle  = static_cast<T>(_2PI_) / num_vertices;
-      for (size_t i = 0; i < num_vertices; i++){
-        this->_normals[i][0] = cos(delta_angle * i);
-        this->_normals[i][1] = sin(delta_angle * i);
-        for (uint8_t j = 2; j < 3; j++)
-          this->_normals[i][j] = 0.0;
-
-        this->_vertices[i] = center + radius * this->_normals[i];
-      }
-    }
-
-    Circle(const Circle& c) : Shape<T, 3>(c), _radius{c._radius}, _center{c._center} {}
-
-    ~Circle(){};
-
-    T radius() const { return _radius; }
-
-    const Point<T, 3> & center() const { return _center; }
-
-    T length() const { return Circle::length(_radius); }
-    T area() const { return Circle::area(_radius); }
-    T volume() const { return 0.0; }
-
-    static T length(T radius) { return static_cast<T>(_2PI_) * radius; }
-    static T area(T radius) { return static_cast<T>(_PI_) * radius * radius; }
-
-    virtual void rotate3D(T angle, Eigen::Matrix<T, 3, 1> axis){
-      this->Shape<T, 3>::rotate3D(angle, axis);
-
-      _center = Eigen::AngleAxis<T>(angle, axis) * _center;
-    }
-
-    friend std::ostream& operator<<(std::ostream& os, const Circle<T>& c) {
-      os << "{ *** CIRCLE R=" << c.radius() << " (" << c.size() << " vertices) ***" << std::endl;
-      os << " Center: " << c.center();
-      auto it = c._vertices.begin();
-      while(it != c._vertices.end())
-        os << *(it++);
-      os << "}" << std::endl;
-
-      return os;
-    }
-
-  }; // class Circle
-
-} // namespace geo
-
-#undef DEF_RADIUS
-#undef DEF_NUM_VERTICES
-
-#endif // CIRCLE_H
+#ifndef CIRCLE_H
+#define CIRCLE_H
+
+#include <cmath>
+
+#include "../constants.h"
+#include "../shape.h"
+#include "../mesh.h"
+#include "../intersection.h"
+#include "../unit_circle.h"
+
+#define DEF_RADIUS 1
+#define DEF_NUM_VERTICES 36
+
+namespace geo {
+
+  /** CLASS Circle
+    * Template params:
+    *                 T --> type used for the coordinates
+    * A circle is a 2D figure. Additional dimensions will be completed with coordinate value 0.0
+    * The circle is centered at the origin
+    * Parameters:
+    *            - radius (default = 1)
+    *            - num_vertices (default = 36, 1 vertex per 10°)
+    */
+
+  template <typename T = float>
+  class Circle : public Shape<T, 3>{
+  public:
+    typedef typename Shape<T, 3>::allocator_type allocator_type;
+
+  protected:
+    T _radius;
+    Point<T, 3> _center;
+    Eigen::Matrix<T, 3, 1> _normal;
+
+    bool hasAnalyticBounds() const override { return true; }
+
+    void analyticBounds(Eigen::AlignedBox<T, 3>& aabb, BoundingSphere<T, 3>& sphere) const override {
+      Eigen::Matrix<T, 3, 1> extents = diskExtents(_normal, _radius);
+      aabb = Eigen::AlignedBox<T, 3>(_center - extents, _center + extents);
+      sphere.center = _center;
+      sphere.radius = _radius;
+    }
+
+  public:
+    Circle() : Circle(DEF_RADIUS, Point<T, 3>(), DEF_NUM_VERTICES) {}
+
+    Circle(T radius) : Circle(radius, Point<T, 3>(), DEF_NUM_VERTICES) {}
+
+    Circle(T radius, size_t num_vertices) : Circle(radius, Point<T, 3>(), num_vertices) {}
+
+    Circle(T radius, Point<T, 3> center, size_t num_vertices = DEF_NUM_VERTICES, const allocator_type& alloc = {}) :
+            Shape<T, 3>(alloc), _radius{radius}, _center{center}, _normal{Eigen::Matrix<T, 3, 1>::UnitZ()} {
+      GEO_SCOPED_TIMER(SHAPE_CONSTRUCTION);
+      this->allocate(num_vertices, num_vertices);
+
+      generate(radius, center, num_vertices, this->_vertices.begin(), this->_normals.begin());
+    }
+
+    Circle(const Circle& c, const allocator_type& alloc = {}) : Shape<T, 3>(c, alloc), _radius{c._radius}, _center{c._center}, _normal{c._normal} {}
+
+    Circle(Circle&& c) = default;
+
+    Circle& operator=(const Circle& c) = default;
+    Circle& operator=(Circle&& c) = default;
+
+    ~Circle(){};
+
+    T radius() const { return _radius; }
+
+    const Point<T, 3> & center() const { return _center; }
+
+    const Eigen::Matrix<T, 3, 1> & normal() const { return _normal; }
+
+    T length() const { return Circle::length(_radius); }
+    T area() const override { return Circle::area(_radius); }
+    T volume() const override { return 0.0; }
+
+    static T length(T radius) { return static_cast<T>(_2PI_) * radius; }
+    static T area(T radius) { return static_cast<T>(_PI_) * radius * radius; }
+
+    /**
+      * Writes the num_vertices vertices and normals of a circle (the ones of the constructor) into output iterators (e.g. PackedOutput for
+      * a staging buffer), without building the shape. Returns the iterators past the last written elements
+      */
+    template <typename VERTEX_OUT, typename NORMAL_OUT>
+    static std::pair<VERTEX_OUT, NORMAL_OUT> generate(T radius, const Point<T, 3>& center, size_t num_vertices, VERTEX_OUT vertices, NORMAL_OUT normals) {
+      // Calculate the vertices starting from (+radius,0)
+      const std::vector<Eigen::Matrix<T, 2, 1>> & unit = unitCircle<T>(num_vertices);
+      for (size_t i = 0; i < num_vertices; i++){
+        *vertices++ = Point<T, 3>(center.x() + radius * unit[i].x(), center.y() + radius * unit[i].y(), center.z());
+        *normals++ = Eigen::Matrix<T, 3, 1>(unit[i].x(), unit[i].y(), 0);
+      }
+
+      return {vertices, normals};
+    }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis) override {
+      this->Shape<T, 3>::rotate3D(angle, axis);
+
+      _center = Eigen::AngleAxis<T>(angle, axis) * _center;
+      _normal = Eigen::AngleAxis<T>(angle, axis) * _normal;
+    }
+
+    /**
+      * Ray intersection (see Shape::intersect), and its version for packets of W rays
+      */
+    bool intersect(const Ray<T>& ray, T& t) const override { return intersectSingle(*this, ray, t); }
+
+    template <int W>
+    Eigen::Array<bool, W, 1> intersect(const RayPacket<T, W>& rays, Eigen::Array<T, W, 1>& t) const {
+      if (this->scaled()) return intersectMesh(rays, this->cachedMesh([this]{ return this->toMesh(); }), t);
+      return intersectDisk(rays, _center, _normal, _radius, t);
+    }
+
+    /**
+      * Triangle mesh: fan around the center of the circle, with the normal of its plane
+      */
+    MeshSize meshSize() const { return MeshSize{this->size() + 1, 3 * this->size()}; }
+
+    template <typename INDEX>
+    void toMesh(T* vertex_buffer, INDEX* index_buffer) const {
+      MeshWriter<T, INDEX> mesh(meshSize(), vertex_buffer, index_buffer);
+
+      const Point<T, 3>* ring = this->vertices().data();
+      mesh.fan(ring, this->size(), MeshWriter<T, INDEX>::polygonNormal(ring, this->size()), false);
+    }
+
+    template <typename INDEX = uint32_t>
+    Mesh<T, INDEX> toMesh() const { return makeMesh<T, INDEX>(*this); }
+
+    friend std::ostream& operator<<(std::ostream& os, const Circle<T>& c) {
+      os << "{ *** CIRCLE R=" << c.radius() << " (" << c.size() << " vertices) ***" << std::endl;
+      os << " Center: " << c.center();
+      auto it = c.vertices().begin();
+      while(it != c.vertices().end())
+        os << *(it++);
+      os << "}" << std::endl;
+
+      return os;
+    }
+
+  }; // class Circle
+
+} // namespace geo
+
+#undef DEF_RADIUS
+#undef DEF_NUM_VERTICES
+
+#endif // CIRCLE_H
@@ -1,104 +1,168 @@
-#ifndef RECTANGLE_H
-#define RECTANGLE_H
-
-#include "../shape.h"
-
-#define DEF_WIDTH 1
-#define DEF_HEIGHT 1
-
-namespace geo {
-
-  /** CLASS Rectangle
-    * Template params:
-    *                 T --> type used for the coordinates
-    * A Rectangle is a 2D figure. Additional dimensions will be completed with coordinate value 0.0
-    * The Rectangle is centered at the origin
-    * Parameters:
-    *            - width (default = 1)
-    *            - height (default = 1)
-    */
-
-  template <typename T = float>
-  class Rectangle : public Shape<T, 3>{
-  protected:
-    T _width;
-    T _height;
-    Point<T, 3> _center;
-
-  public:
-    Rectangle() : Rectangle(DEF_WIDTH, DEF_HEIGHT, Point<T, 3>()) {}
-
-    Rectangle(T length) : Rectangle(length, length, Point<T, 3>()) {}
-
-    Rectangle(T width, T height) : Rectangle(width, height, Point<T, 3>()) {}
-
-    Rectangle(T width, T height, Point<T, 3> center) : _width{width}, _height{height}, _center{center} {
-      this->_vertices.resize(4);
-      this->_normals.resize(4);
-
-      // Calculate the vertices starting from bottom-left (anticlockwise)
-      this->_vertices[0][0] = center.x() - _width/static_cast<T>(2.0);
-      this->_vertices[0][1] = center.y() - _height/static_cast<T>(2.0);
-      this->_vertices[0][2] = center.z();
-      this->_vertices[1][0] = center.x() + _width/static_cast<T>(2.0);
-      this->_vertices[1][1] = center.y() - _height/static_cast<T>(2.0);
-      this->_vertices[1][2] = center.z();
-      this->_vertices[2][0] = center.x() + _width/static_cast<T>(2.0);
-      this->_vertices[2][1] = center.y() + _height/static_cast<T>(2.0);
-      this->_vertices[2][2] = center.z();
-      this->_vertices[3][0] = center.x() - _width/static_cast<T>(2.0);
-      this->_vertices[3][1] = center.x() + _height/static_cast<T>(2.0);
-      this->_vertices[3][2] = center.z();
-
-      // Normals to the sides, starting with the bottom side
-      this->_normals[0][0] = 0.0;
-      this->_normals[0][1] = static_cast<T>(-1.0);
-      this->_normals[1][0] = static_cast<T>(1.0);
-      this->_normals[1][1] = 0.0;
-      this->_normals[2][0] = 0.0;
-      this->_normals[2][1] = static_cast<T>(1.0);
-      this->_normals[3][0] = static_cast<T>(-1.0);
-      this->_normals[3][1] = 0.0;
-    }
-
-    Rectangle(const Rectangle& c) : Shape<T, 3>(c), _width{c._width}, _height{c._height}, _center{c._center} {}
-
-    ~Rectangle(){};
-
-    T width() const { return _width; }
-    T height() const { return _height; }
-
-    const Point<T, 3> & center() const { return _center; }
-
-    T length() const { return Rectangle::length(_width, _height); }
-    T area() const { return Rectangle::area(_width, _height); }
-    T volume() const { return 0.0; }
-
-    static T length(T width, T height) { return static_cast<T>(2.0) * (width + height); }
-    static T area(T width, T height) { return  width * height; }
-
-    virtual void rotate3D(T angle, Eigen::Matrix<T, 3, 1> axis){
-      this->Shape<T, 3>::rotate3D(angle, axis);
-
-      _center = Eigen::AngleAxis<T>(angle, axis) * _center;
-    }
-
-    friend std::ostream& operator<<(std::ostream& os, const Rectangle<T>& rec) {
-      os << "{ *** Rectangle W=" << rec.width() << " H=" << rec.height() << " ***" << std::endl;
-      os << " Center: " << rec.center();
-      auto it = rec._vertices.begin();
-      while(it != rec._vertices.end())
-        os << *(it++);
-      os << "}" << std::endl;
-
-      return os;
-    }
-
-  }; // class Rectangle
-
-} // namespace geo
-
-#undef DEF_WIDTH
-#undef DEF_HEIGHT
-
-#endif // RECTANGLE_H
+#ifndef RECTANGLE_H
+#define RECTANGLE_H
+
+#include "../shape.h"
+#include "../mesh.h"
+#include "../intersection.h"
+
+#define DEF_WIDTH 1
+#define DEF_HEIGHT 1
+
+namespace geo {
+
+  /** CLASS Rectangle
+    * Template params:
+    *                 T --> type used for the coordinates
+    * A Rectangle is a 2D figure. Additional dimensions will be completed with coordinate value 0.0
+    * The Rectangle is centered at the origin
+    * Parameters:
+    *            - width (default = 1)
+    *            - height (default = 1)
+    */
+
+  template <typename T = float>
+  class Rectangle : public Shape<T, 3>{
+  public:
+    typedef typename Shape<T, 3>::allocator_type allocator_type;
+
+  protected:
+    T _width;
+    T _height;
+    Point<T, 3> _center;
+
+    // Orientation of the rectangle: directions of the width and the height (the normals to the right and up sides)
+    Eigen::Matrix<T, 3, 1> _width_axis;
+    Eigen::Matrix<T, 3, 1> _height_axis;
+
+    bool hasAnalyticBounds() const override { return true; }
+
+    void analyticBounds(Eigen::AlignedBox<T, 3>& aabb, BoundingSphere<T, 3>& sphere) const override {
+      Eigen::Matrix<T, 3, 1> extents = (_width_axis * (_width / static_cast<T>(2.0))).cwiseAbs()
+                                       + (_height_axis * (_height / static_cast<T>(2.0))).cwiseAbs();
+      aabb = Eigen::AlignedBox<T, 3>(_center - extents, _center + extents);
+      sphere.center = _center;
+      sphere.radius = std::sqrt(_width * _width + _height * _height) / static_cast<T>(2.0);
+    }
+
+  public:
+    Rectangle() : Rectangle(DEF_WIDTH, DEF_HEIGHT, Point<T, 3>()) {}
+
+    Rectangle(T length) : Rectangle(length, length, Point<T, 3>()) {}
+
+    Rectangle(T width, T height) : Rectangle(width, height, Point<T, 3>()) {}
+
+    Rectangle(T width, T height, Point<T, 3> center, const allocator_type& alloc = {}) : Shape<T, 3>(alloc), _width{width}, _height{height}, _center{center},
+                                                                                          _width_axis{Eigen::Matrix<T, 3, 1>::UnitX()}, _height_axis{Eigen::Matrix<T, 3, 1>::UnitY()} {
+      GEO_SCOPED_TIMER(SHAPE_CONSTRUCTION);
+      this->allocate(4, 4);
+
+      generate(width, height, center, this->_vertices.begin(), this->_normals.begin());
+    }
+
+    Rectangle(const Rectangle& c, const allocator_type& alloc = {}) : Shape<T, 3>(c, alloc), _width{c._width}, _height{c._height}, _center{c._center},
+                                                                  _width_axis{c._width_axis}, _height_axis{c._height_axis} {}
+
+    Rectangle(Rectangle&& c) = default;
+
+    Rectangle& operator=(const Rectangle& c) = default;
+    Rectangle& operator=(Rectangle&& c) = default;
+
+    ~Rectangle(){};
+
+    T width() const { return _width; }
+    T height() const { return _height; }
+
+    const Point<T, 3> & center() const { return _center; }
+    const Eigen::Matrix<T, 3, 1> & width_axis() const { return _width_axis; }
+    const Eigen::Matrix<T, 3, 1> & height_axis() const { return _height_axis; }
+
+    T length() const { return Rectangle::length(_width, _height); }
+    T area() const override { return Rectangle::area(_width, _height); }
+    T volume() const override { return 0.0; }
+
+    static T length(T width, T height) { return static_cast<T>(2.0) * (width + height); }
+    static T area(T width, T height) { return  width * height; }
+
+    /**
+      * Writes the 4 vertices and 4 normals of a rectangle (the ones of the constructor) into output iterators, without building the shape.
+      * Returns the iterators past the last written elements
+      */
+    template <typename VERTEX_OUT, typename NORMAL_OUT>
+    static std::pair<VERTEX_OUT, NORMAL_OUT> generate(T width, T height, const Point<T, 3>& center, VERTEX_OUT vertices, NORMAL_OUT normals) {
+      const T half_width {width / static_cast<T>(2.0)};
+      const T half_height {height / static_cast<T>(2.0)};
+
+      // Calculate the vertices starting from bottom-left (anticlockwise)
+      *vertices++ = Point<T, 3>(center.x() - half_width, center.y() - half_height, center.z());
+      *vertices++ = Point<T, 3>(center.x() + half_width, center.y() - half_height, center.z());
+      *vertices++ = Point<T, 3>(center.x() + half_width, center.y() + half_height, center.z());
+      *vertices++ = Point<T, 3>(center.x() - half_width, center.y() + half_height, center.z());
+
+      // Normals to the sides, starting with the bottom side
+      *normals++ = Eigen::Matrix<T, 3, 1>(0, static_cast<T>(-1.0), 0);
+      *normals++ = Eigen::Matrix<T, 3, 1>(static_cast<T>(1.0), 0, 0);
+      *normals++ = Eigen::Matrix<T, 3, 1>(0, static_cast<T>(1.0), 0);
+      *normals++ = Eigen::Matrix<T, 3, 1>(static_cast<T>(-1.0), 0, 0);
+
+      return {vertices, normals};
+    }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis) override {
+      this->Shape<T, 3>::rotate3D(angle, axis);
+
+      _center = Eigen::AngleAxis<T>(angle, axis) * _center;
+      _width_axis = Eigen::AngleAxis<T>(angle, axis) * _width_axis;
+      _height_axis = Eigen::AngleAxis<T>(angle, axis) * _height_axis;
+    }
+
+    /**
+      * Ray intersection (see Shape::intersect), and its version for packets of W rays
+      */
+    bool intersect(const Ray<T>& ray, T& t) const override { return intersectSingle(*this, ray, t); }
+
+    template <int W>
+    Eigen::Array<bool, W, 1> intersect(const RayPacket<T, W>& rays, Eigen::Array<T, W, 1>& t) const {
+      if (this->scaled()) return intersectMesh(rays, this->cachedMesh([this]{ return this->toMesh(); }), t);
+      return intersectRectangle(rays, _center, _width_axis, _height_axis, _width / static_cast<T>(2.0), _height / static_cast<T>(2.0), t);
+    }
+
+    /**
+      * Triangle mesh: 2 triangles, with the normal of the plane of the rectangle
+      */
+    MeshSize meshSize() const { return MeshSize{4, 6}; }
+
+    template <typename INDEX>
+    void toMesh(T* vertex_buffer, INDEX* index_buffer) const {
+      MeshWriter<T, INDEX> mesh(meshSize(), vertex_buffer, index_buffer);
+
+      const Point<T, 3>* corners = this->vertices().data();
+      Eigen::Matrix<T, 3, 1> normal = MeshWriter<T, INDEX>::polygonNormal(corners, 4);
+      for(uint8_t i = 0; i < 4; i++)
+        mesh.vertex(corners[i], normal);
+
+      mesh.triangle(0, 1, 2);
+      mesh.triangle(0, 2, 3);
+    }
+
+    template <typename INDEX = uint32_t>
+    Mesh<T, INDEX> toMesh() const { return makeMesh<T, INDEX>(*this); }
+
+    friend std::ostream& operator<<(std::ostream& os, const Rectangle<T>& rec) {
+      os << "{ *** Rectangle W=" << rec.width() << " H=" << rec.height() << " ***" << std::endl;
+      os << " Center: " << rec.center();
+      auto it = rec.vertices().begin();
+      while(it != rec.vertices().end())
+        os << *(it++);
+      os << "}" << std::endl;
+
+      return os;
+    }
+
+  }; // class Rectangle
+
+} // namespace geo
+
+#undef DEF_WIDTH
+#undef DEF_HEIGHT
+
+#endif // RECTANGLE_H
@@ -0,0 +1,64 @@
+#ifndef STATIC_CIRCLE_H
+#define STATIC_CIRCLE_H
+
+#include "../constants.h"
+#include "../static_shape.h"
+#include "../unit_circle.h"
+
+#define DEF_RADIUS 1
+
+namespace geo {
+
+  /** CLASS StaticCircle
+    * Template params:
+    *                 T --> type used for the coordinates
+    *                 N --> number of vertices (default = 36, 1 vertex per 10 degrees)
+    * Fixed-size version of Circle (same vertices and normals). The unit circle points are computed at compile time.
+    * Parameters:
+    *            - radius (default = 1)
+    *            - center (default = origin)
+    */
+
+  template <typename T = float, size_t N = 36>
+  class StaticCircle : public StaticShape<T, 3, N, N>{
+    static constexpr std::array<T, 2 * N> _unit_circle = staticUnitCircle<T, N>();
+
+  protected:
+    T _radius;
+    Point<T, 3> _center;
+
+  public:
+    StaticCircle() : StaticCircle(DEF_RADIUS, Point<T, 3>()) {}
+
+    StaticCircle(T radius) : StaticCircle(radius, Point<T, 3>()) {}
+
+    StaticCircle(T radius, const Point<T, 3>& center) : _radius{radius}, _center{center} {
+      // Calculate the vertices starting from (+radius,0)
+      for (size_t i = 0; i < N; i++){
+        this->_normals[i] = Eigen::Matrix<T, 3, 1>(_unit_circle[2 * i], _unit_circle[2 * i + 1], 0);
+
+        this->_vertices[i] = center + radius * this->_normals[i];
+      }
+    }
+
+    T radius() const { return _radius; }
+
+    const Point<T, 3> & center() const { return _center; }
+
+    T length() const { return static_cast<T>(_2PI_) * _radius; }
+    T area() const { return static_cast<T>(_PI_) * _radius * _radius; }
+    T volume() const { return 0.0; }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis){
+      StaticShape<T, 3, N, N>::rotate3D(angle, axis);
+
+      _center = Eigen::AngleAxis<T>(angle, axis) * _center;
+    }
+
+  }; // class StaticCircle
+
+} // namespace geo
+
+#undef DEF_RADIUS
+
+#endif // STATIC_CIRCLE_H
@@ -0,0 +1,68 @@
+#ifndef STATIC_RECTANGLE_H
+#define STATIC_RECTANGLE_H
+
+#include "../static_shape.h"
+
+#define DEF_WIDTH 1
+#define DEF_HEIGHT 1
+
+namespace geo {
+
+  /** CLASS StaticRectangle
+    * Template params:
+    *                 T --> type used for the coordinates
+    * Fixed-size version of Rectangle (same vertices and normals)
+    * Parameters:
+    *            - width (default = 1)
+    *            - height (default = 1)
+    *            - center (default = origin)
+    */
+
+  template <typename T = float>
+  class StaticRectangle : public StaticShape<T, 3, 4, 4>{
+    // Corners of the unit square, starting from bottom-left (anticlockwise), and normals to the sides, starting with the bottom side
+    static constexpr T _corners[4][2] { {-0.5, -0.5}, {0.5, -0.5}, {0.5, 0.5}, {-0.5, 0.5} };
+    static constexpr T _side_normals[4][2] { {0, -1}, {1, 0}, {0, 1}, {-1, 0} };
+
+  protected:
+    T _width;
+    T _height;
+    Point<T, 3> _center;
+
+  public:
+    StaticRectangle() : StaticRectangle(DEF_WIDTH, DEF_HEIGHT, Point<T, 3>()) {}
+
+    StaticRectangle(T length) : StaticRectangle(length, length, Point<T, 3>()) {}
+
+    StaticRectangle(T width, T height) : StaticRectangle(width, height, Point<T, 3>()) {}
+
+    StaticRectangle(T width, T height, const Point<T, 3>& center) : _width{width}, _height{height}, _center{center} {
+      for (uint8_t i = 0; i < 4; i++){
+        this->_vertices[i] = center + Eigen::Matrix<T, 3, 1>(_corners[i][0] * width, _corners[i][1] * height, 0);
+        this->_normals[i] = Eigen::Matrix<T, 3, 1>(_side_normals[i][0], _side_normals[i][1], 0);
+      }
+    }
+
+    T width() const { return _width; }
+    T height() const { return _height; }
+
+    const Point<T, 3> & center() const { return _center; }
+
+    T length() const { return static_cast<T>(2.0) * (_width + _height); }
+    T area() const { return _width * _height; }
+    T volume() const { return 0.0; }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis){
+      StaticShape<T, 3, 4, 4>::rotate3D(angle, axis);
+
+      _center = Eigen::AngleAxis<T>(angle, axis) * _center;
+    }
+
+  }; // class StaticRectangle
+
+} // namespace geo
+
+#undef DEF_WIDTH
+#undef DEF_HEIGHT
+
+#endif // STATIC_RECTANGLE_H
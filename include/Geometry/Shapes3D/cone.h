@@ -1,106 +1,185 @@
-#ifndef CONE_H
-#define CONE_H
-
-#include <vector>
-#include <cmath>
-
-#include "../shape.h"
-#include "../Shapes2D/circle.h"
-#include "../point.h"
-
-#define DEF_RADIUS 1
-#define DEF_HEIGHT 1
-#define DEF_NUM_VERTICES 36
-
-namespace geo {
-
-  /** CLASS Cone
-    * Template params:
-    *                 T --> type used for the coordinates
-    *
-    * A Cone is a 3D figure.
-    * The circle is centered at the origin
-    * Parameters:
-    *            - radius (default = 1)
-    *            - height (default = 1)
-    *            - num_vertices (default = 36, 1 vertex per 10 in the base circle)
-    */
-
-  template <typename T = float>
-  class Cone : public Shape<T, 3>{
-  protected:
-    T _radius;
-    T _height;
-    Point<T, 3> _base_center;
-
-  public:
-    Cone() : Cone(DEF_RADIUS, DEF_HEIGHT, Point<T, 3>(), DEF_NUM_VERTICES) {}
-
-    Cone(T radius, T height) : Cone(radius, height, Point<T, 3>(), DEF_NUM_VERTICES) {}
-
-    Cone(T radius, T height, size_t base_num_vertices) : Cone(radius, height, Point<T, 3>(), base_num_vertices) {}
-
-    Cone(T radius, T height, const Point<T, 3>& base_center, size_t base_num_vertices = DEF_NUM_VERTICES) : _radius{radius}, _height{height}, _base_center{base_center}{
-      Circle<T> base(radius, base_center, base_num_vertices);
-      Point<T, 3> tip(base_center.x(), base_center.y(), base_center.z() +  height);
-
-      // Reserve one additional vertex for the center of the base and
-      // as many as base circle vertices for the tip (in order to be able to provide the right normals for the tip "singularity")
-      this->_vertices.resize(base.size() + 1);
-      this->_normals.resize(this->_vertices.size());
-
-//      // Copy vertices data and calculate normals
-//      this->_vertices[0] = base[0];
-//      this->_normals[0] = (-1.0) * base.normals()[0];
-
-      T xy_comp { static_cast<T>(1.0f) / std::sqrt(static_cast<T>(1.0f) + radius * radius / height / height) };
-      T z_comp { radius / height * xy_comp };
-      T delta_angle = _2PI_ / base_num_vertices;
-      for(size_t i = 0; i < base_num_vertices; i++){
-        this->_vertices[i] = base[i];
-        this->_normals[i] = xy_comp * (Eigen::AngleAxis<T>(i * delta_angle, Eigen::Matrix<T, 3, 1>::UnitZ()) * Eigen::Matrix<T, 3, 1>::UnitX())
-                            + z_comp * Eigen::Matrix<T, 3, 1>::UnitZ();
-      }
-      this->_vertices[base_num_vertices] = tip;
-      this->_normals[base_num_vertices] = Eigen::Matrix<T, 3, 1>::UnitZ();
-    }
-
-    Cone(const Cone& c) : Shape<T, 3>(c), _radius{c._radius}, _height{c._height}, _base_center{c._base_center} {}
-
-    ~Cone(){}
-
-    T radius() const { return _radius; }
-    T height() const { return _height; }
-    const Point<T, 3> & base_center() const { return _base_center; }
-    Eigen::Matrix<T, 3, 1> base_normal() const { return -Eigen::Matrix<T, 3, 1>::UnitZ(); }
-
-    T area() const { return Cone::area(_radius, _height); }
-    T volume() const { return Cone::volume(_radius, _height); }
-    static T area(T radius, T height) { return static_cast<T>(_PI_) * radius * (radius + sqrt(radius * radius + height * height)); }
-    static T volume(T radius, T height) { return static_cast<T>(_PI_) * radius * radius * height / 3; }
-
-    virtual void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis){
-      Shape<T, 3>::rotate3D(angle, axis);
-
-      _base_center = Eigen::AngleAxis<T>(angle, axis) * _base_center;
-    }
-
-    friend std::ostream& operator<<(std::ostream& os, const Cone<T>& c) {
-      os << "{ *** CONE R=" << c.radius() << " H=" << c.height() << " (" << c.size() << " vertices) ***" << std::endl;
-      os << " Base Center: " << base_center();
-      auto it = c._vertices.begin();
-      while(it != c._vertices.end())
-        os << *(it++);
-      os << "}" << std::endl;
-
-      return os;
-    }
-  }; // class Cone
-
-} // namespace geo
-
-#undef DEF_RADIUS
-#undef DEF_HEIGHT
-#undef DEF_NUM_VERTICES
-
-#endif // CONE_H
+#ifndef CONE_H
+#define CONE_H
+
+#include <vector>
+#include <cmath>
+
+#include "../constants.h"
+#include "../shape.h"
+#include "../mesh.h"
+#include "../intersection.h"
+#include "../unit_circle.h"
+#include "../point.h"
+
+#define DEF_RADIUS 1
+#define DEF_HEIGHT 1
+#define DEF_NUM_VERTICES 36
+
+namespace geo {
+
+  /** CLASS Cone
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * A Cone is a 3D figure.
+    * The circle is centered at the origin
+    * Parameters:
+    *            - radius (default = 1)
+    *            - height (default = 1)
+    *            - num_vertices (default = 36, 1 vertex per 10° in the base circle)
+    */
+
+  template <typename T = float>
+  class Cone : public Shape<T, 3>{
+  public:
+    typedef typename Shape<T, 3>::allocator_type allocator_type;
+
+  protected:
+    T _radius;
+    T _height;
+    Point<T, 3> _base_center;
+    Eigen::Matrix<T, 3, 1> _base_normal;
+
+    bool hasAnalyticBounds() const override { return true; }
+
+    void analyticBounds(Eigen::AlignedBox<T, 3>& aabb, BoundingSphere<T, 3>& sphere) const override {
+      Eigen::Matrix<T, 3, 1> extents = diskExtents(_base_normal, _radius);
+      aabb = Eigen::AlignedBox<T, 3>(_base_center - extents, _base_center + extents);
+      aabb.extend(Eigen::Matrix<T, 3, 1>(_base_center - _height * _base_normal));
+
+      // Smallest sphere: centered in the base if the tip is inside the base sphere, otherwise through the tip and the base circle
+      if (_height <= _radius){
+        sphere.center = _base_center;
+        sphere.radius = _radius;
+      }
+      else{
+        T distance = (_height * _height - _radius * _radius) / (static_cast<T>(2.0) * _height);
+        sphere.center = _base_center - distance * _base_normal;
+        sphere.radius = _height - distance;
+      }
+    }
+
+  public:
+    Cone() : Cone(DEF_RADIUS, DEF_HEIGHT, Point<T, 3>(), DEF_NUM_VERTICES) {}
+
+    Cone(T radius, T height) : Cone(radius, height, Point<T, 3>(), DEF_NUM_VERTICES) {}
+
+    Cone(T radius, T height, size_t base_num_vertices) : Cone(radius, height, Point<T, 3>(), base_num_vertices) {}
+
+    Cone(T radius, T height, const Point<T, 3>& base_center, size_t base_num_vertices = DEF_NUM_VERTICES, const allocator_type& alloc = {}) :
+            Shape<T, 3>(alloc), _radius{radius}, _height{height}, _base_center{base_center}, _base_normal{-Eigen::Matrix<T, 3, 1>::UnitZ()} {
+      GEO_SCOPED_TIMER(SHAPE_CONSTRUCTION);
+      // Reserve one additional vertex for the tip
+      this->allocate(base_num_vertices + 1, base_num_vertices + 1);
+
+      generate(radius, height, base_center, base_num_vertices, this->_vertices.begin(), this->_normals.begin());
+    }
+
+    Cone(const Cone& c, const allocator_type& alloc = {}) : Shape<T, 3>(c, alloc), _radius{c._radius}, _height{c._height}, _base_center{c._base_center}, _base_normal{c._base_normal} {}
+
+    Cone(Cone&& c) = default;
+
+    Cone& operator=(const Cone& c) = default;
+    Cone& operator=(Cone&& c) = default;
+
+    ~Cone(){}
+
+    T radius() const { return _radius; }
+    T height() const { return _height; }
+    const Point<T, 3> & base_center() const { return _base_center; }
+    Eigen::Matrix<T, 3, 1> base_normal() const { return _base_normal; }
+
+    T area() const override { return Cone::area(_radius, _height); }
+    T volume() const override { return Cone::volume(_radius, _height); }
+    static T area(T radius, T height) { return static_cast<T>(_PI_) * radius * (radius + sqrt(radius * radius + height * height)); }
+    static T volume(T radius, T height) { return static_cast<T>(_PI_) * radius * radius * height / 3; }
+
+    /**
+      * Writes the base_num_vertices + 1 vertices and normals of a cone (the ones of the constructor: base ring, then tip) into output iterators,
+      * without building the shape. Returns the iterators past the last written elements
+      */
+    template <typename VERTEX_OUT, typename NORMAL_OUT>
+    static std::pair<VERTEX_OUT, NORMAL_OUT> generate(T radius, T height, const Point<T, 3>& base_center, size_t base_num_vertices,
+                                                      VERTEX_OUT vertices, NORMAL_OUT normals) {
+      T xy_comp { static_cast<T>(1.0f) / std::sqrt(static_cast<T>(1.0f) + radius * radius / height / height) };
+      T z_comp { radius / height * xy_comp };
+      const std::vector<Eigen::Matrix<T, 2, 1>> & unit = unitCircle<T>(base_num_vertices);
+      for(size_t i = 0; i < base_num_vertices; i++){
+        *vertices++ = Point<T, 3>(base_center.x() + radius * unit[i].x(), base_center.y() + radius * unit[i].y(), base_center.z());
+        *normals++ = Eigen::Matrix<T, 3, 1>(xy_comp * unit[i].x(), xy_comp * unit[i].y(), z_comp);
+      }
+
+      // Tip
+      *vertices++ = Point<T, 3>(base_center.x(), base_center.y(), base_center.z() + height);
+      *normals++ = Eigen::Matrix<T, 3, 1>::UnitZ();
+
+      return {vertices, normals};
+    }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis) override {
+      Shape<T, 3>::rotate3D(angle, axis);
+
+      _base_center = Eigen::AngleAxis<T>(angle, axis) * _base_center;
+      _base_normal = Eigen::AngleAxis<T>(angle, axis) * _base_normal;
+    }
+
+    /**
+      * Ray intersection (see Shape::intersect), and its version for packets of W rays
+      */
+    bool intersect(const Ray<T>& ray, T& t) const override { return intersectSingle(*this, ray, t); }
+
+    template <int W>
+    Eigen::Array<bool, W, 1> intersect(const RayPacket<T, W>& rays, Eigen::Array<T, W, 1>& t) const {
+      if (this->scaled()) return intersectMesh(rays, this->cachedMesh([this]{ return this->toMesh(); }), t);
+      return intersectCone(rays, _base_center, Eigen::Matrix<T, 3, 1>(-_base_normal), _radius, _height, t);
+    }
+
+    /**
+      * Triangle mesh: side and base cap (fan around its center, with the base normal).
+      * The tip is repeated once per side triangle, with the normal in the middle of the triangle, to avoid the singularity of the tip normal
+      */
+    MeshSize meshSize() const { return MeshSize{3 * (this->size() - 1) + 1, 6 * (this->size() - 1)}; }
+
+    template <typename INDEX>
+    void toMesh(T* vertex_buffer, INDEX* index_buffer) const {
+      MeshWriter<T, INDEX> mesh(meshSize(), vertex_buffer, index_buffer);
+
+      size_t n = this->size() - 1;
+      const Point<T, 3>* base = this->vertices().data();
+      const Point<T, 3>& tip = this->vertices()[n];
+
+      // Side
+      for(size_t i = 0; i < n; i++)
+        mesh.vertex(base[i], this->normals()[i]);
+      for(size_t i = 0; i < n; i++){
+        INDEX next = (i + 1) % n;
+        INDEX tip_index = mesh.vertex(tip, (this->normals()[i] + this->normals()[next]).normalized());
+        mesh.triangle(i, next, tip_index);
+      }
+
+      // Base (the ring is anticlockwise seen from the tip)
+      mesh.fan(base, n, -MeshWriter<T, INDEX>::polygonNormal(base, n), true);
+    }
+
+    template <typename INDEX = uint32_t>
+    Mesh<T, INDEX> toMesh() const { return makeMesh<T, INDEX>(*this); }
+
+    friend std::ostream& operator<<(std::ostream& os, const Cone<T>& c) {
+      os << "{ *** CONE R=" << c.radius() << " H=" << c.height() << " (" << c.size() << " vertices) ***" << std::endl;
+      os << " Base Center: " << c.base_center();
+      auto it = c.vertices().begin();
+      while(it != c.vertices().end())
+        os << *(it++);
+      os << "}" << std::endl;
+
+      return os;
+    }
+  }; // class Cone
+
+} // namespace geo
+
+#undef DEF_RADIUS
+#undef DEF_HEIGHT
+#undef DEF_NUM_VERTICES
+
+#endif // CONE_H
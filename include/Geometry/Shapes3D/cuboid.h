@@ -1,102 +1,191 @@
-#ifndef CUBOID_H
-#define CUBOID_H
-
-#include "../shape.h"
-#include "../Shapes2D/rectangle.h"
-
-#define DEF_WIDTH 1
-#define DEF_HEIGHT 1
-#define DEF_DEPTH 1
-
-namespace geo {
-
-  /** CLASS Cuboid
-    * Template params:
-    *                 T --> type used for the coordinates
-    * A Cuboid is a 3D figure.
-    * The Cuboid is centered at the origin
-    * Parameters:
-    *            - width (default = 1)
-    *            - height (default = 1)
-    *            - depth (default = 1)
-    */
-
-  template <typename T = float>
-  class Cuboid : public Shape<T, 3>{
-  protected:
-    T _width;
-    T _height;
-    T _depth;
-    Point<T, 3> _center;
-
-  public:
-    Cuboid() : Cuboid(DEF_WIDTH, DEF_HEIGHT, DEF_DEPTH, Point<T, 3>()) {}
-
-    Cuboid(T length) : Cuboid(length, length, length, Point<T, 3>()) {}
-
-    Cuboid(T width, T height, T depth) : Cuboid(width, height, depth, Point<T, 3>()) {}
-
-    Cuboid(T width /*X*/, T height /*Z*/, T depth /*Y*/, Point<T, 3> center) : _width{width}, _height{height}, _depth{depth}, _center{center} {
-      this->_vertices.resize(8);
-      this->_normals.resize(6);
-
-      // Calculate the vertices starting from bottom-left (anticlockwise)
-      //    Bottom & up Faces
-      Rectangle<T> bottom(_width, _depth, Point<T, 3> (_center.x(), _center.y(), _center.z() - height / static_cast<T>(2.0)));
-      Rectangle<T> up(_width, _depth, Point<T, 3> (_center.x(), _center.y(), _center.z() + height / static_cast<T>(2.0)));
-
-      for (uint8_t i = 0; i < 4; i++){
-        this->_vertices[i] = bottom.vertices()[i];
-        this->_vertices[i + 4] = up.vertices()[i];
-      }
-
-      // Normals to the sides, starting with the bottom side
-      this->_normals[0] = Eigen::Matrix<T, 3, 1>(0, 0, static_cast<T>(-1.0));
-      for (uint8_t i = 0; i < 4; i++)
-        this->_normals[i + 1] = bottom.normals()[i];
-      this->_normals[5] = Eigen::Matrix<T, 3, 1>(0, 0, static_cast<T>(1.0));
-    }
-
-    Cuboid(const Cuboid& c) : Shape<T, 3>(c), _width{c._width}, _height{c._height}, _depth{c._depth}, _center{c._center} {}
-
-    ~Cuboid(){};
-
-    T width() const { return _width; }
-    T height() const { return _height; }
-    T depth() const { return _depth; }
-
-    const Point<T, 3> & center() const { return _center; }
-
-    T area() const { return Cuboid::area(_width, _height, _depth); }
-    T volume() const { return Cuboid::volume(_width, _height, _depth); }
-
-    static T area(T width, T height, T depth) { return  static_cast<T>(2.0) * (width * depth + width * height + depth * height); }
-    static T volume(T width, T height, T depth) { return  width * depth * height; }
-
-    virtual void rotate3D(T angle, Eigen::Matrix<T, 3, 1> axis){
-      this->Shape<T, 3>::rotate3D(angle, axis);
-
-      _center = Eigen::AngleAxis<T>(angle, axis) * _center;
-    }
-
-    friend std::ostream& operator<<(std::ostream& os, const Cuboid<T>& cub) {
-      os << "{ *** Cuboid W=" << cub.width() << " D=" << cub.depth() << " H=" << cub.height() << " ***" << std::endl;
-      os << " Center: " << cub.center();
-      auto it = cub._vertices.begin();
-      while(it != cub._vertices.end())
-        os << *(it++);
-      os << "}" << std::endl;
-
-      return os;
-    }
-
-  }; // class Cuboid
-
-} // namespace geo
-
-#undef DEF_WIDTH
-#undef DEF_HEIGHT
-#undef DEF_DEPTH
-
-
-#endif // CUBOID_H
+#ifndef CUBOID_H
+#define CUBOID_H
+
+#include "../shape.h"
+#include "../mesh.h"
+#include "../intersection.h"
+
+#define DEF_WIDTH 1
+#define DEF_HEIGHT 1
+#define DEF_DEPTH 1
+
+namespace geo {
+
+  /** CLASS Cuboid
+    * Template params:
+    *                 T --> type used for the coordinates
+    * A Cuboid is a 3D figure.
+    * The Cuboid is centered at the origin
+    * Parameters:
+    *            - width (default = 1)
+    *            - height (default = 1)
+    *            - depth (default = 1)
+    */
+
+  template <typename T = float>
+  class Cuboid : public Shape<T, 3>{
+  public:
+    typedef typename Shape<T, 3>::allocator_type allocator_type;
+
+  protected:
+    T _width;
+    T _height;
+    T _depth;
+    Point<T, 3> _center;
+
+    // Orientation of the cuboid: directions of the width, the depth and the height (the normals to the right, back and up faces)
+    Eigen::Matrix<T, 3, 1> _width_axis;
+    Eigen::Matrix<T, 3, 1> _depth_axis;
+    Eigen::Matrix<T, 3, 1> _height_axis;
+
+    bool hasAnalyticBounds() const override { return true; }
+
+    void analyticBounds(Eigen::AlignedBox<T, 3>& aabb, BoundingSphere<T, 3>& sphere) const override {
+      Eigen::Matrix<T, 3, 1> extents = (_width_axis * (_width / static_cast<T>(2.0))).cwiseAbs()
+                                       + (_depth_axis * (_depth / static_cast<T>(2.0))).cwiseAbs()
+                                       + (_height_axis * (_height / static_cast<T>(2.0))).cwiseAbs();
+      aabb = Eigen::AlignedBox<T, 3>(_center - extents, _center + extents);
+      sphere.center = _center;
+      sphere.radius = std::sqrt(_width * _width + _depth * _depth + _height * _height) / static_cast<T>(2.0);
+    }
+
+  public:
+    Cuboid() : Cuboid(DEF_WIDTH, DEF_HEIGHT, DEF_DEPTH, Point<T, 3>()) {}
+
+    Cuboid(T length) : Cuboid(length, length, length, Point<T, 3>()) {}
+
+    Cuboid(T width, T height, T depth) : Cuboid(width, height, depth, Point<T, 3>()) {}
+
+    Cuboid(T width /*X*/, T height /*Z*/, T depth /*Y*/, Point<T, 3> center, const allocator_type& alloc = {}) :
+            Shape<T, 3>(alloc), _width{width}, _height{height}, _depth{depth}, _center{center},
+            _width_axis{Eigen::Matrix<T, 3, 1>::UnitX()}, _depth_axis{Eigen::Matrix<T, 3, 1>::UnitY()}, _height_axis{Eigen::Matrix<T, 3, 1>::UnitZ()} {
+      GEO_SCOPED_TIMER(SHAPE_CONSTRUCTION);
+      this->allocate(8, 6);
+
+      generate(width, height, depth, center, this->_vertices.begin(), this->_normals.begin());
+    }
+
+    Cuboid(const Cuboid& c, const allocator_type& alloc = {}) : Shape<T, 3>(c, alloc), _width{c._width}, _height{c._height}, _depth{c._depth}, _center{c._center},
+                                                              _width_axis{c._width_axis}, _depth_axis{c._depth_axis}, _height_axis{c._height_axis} {}
+
+    Cuboid(Cuboid&& c) = default;
+
+    Cuboid& operator=(const Cuboid& c) = default;
+    Cuboid& operator=(Cuboid&& c) = default;
+
+    ~Cuboid(){};
+
+    T width() const { return _width; }
+    T height() const { return _height; }
+    T depth() const { return _depth; }
+
+    const Point<T, 3> & center() const { return _center; }
+    const Eigen::Matrix<T, 3, 1> & width_axis() const { return _width_axis; }
+    const Eigen::Matrix<T, 3, 1> & depth_axis() const { return _depth_axis; }
+    const Eigen::Matrix<T, 3, 1> & height_axis() const { return _height_axis; }
+
+    T area() const override { return Cuboid::area(_width, _height, _depth); }
+    T volume() const override { return Cuboid::volume(_width, _height, _depth); }
+
+    static T area(T width, T height, T depth) { return  static_cast<T>(2.0) * (width * depth + width * height + depth * height); }
+    static T volume(T width, T height, T depth) { return  width * depth * height; }
+
+    /**
+      * Writes the 8 vertices and 6 normals of a cuboid (the ones of the constructor) into output iterators, without building the shape.
+      * Returns the iterators past the last written elements
+      */
+    template <typename VERTEX_OUT, typename NORMAL_OUT>
+    static std::pair<VERTEX_OUT, NORMAL_OUT> generate(T width, T height, T depth, const Point<T, 3>& center, VERTEX_OUT vertices, NORMAL_OUT normals) {
+      const T half_width {width / static_cast<T>(2.0)};
+      const T half_depth {depth / static_cast<T>(2.0)};
+      const T half_height {height / static_cast<T>(2.0)};
+      const T corners[4][2] {{-half_width, -half_depth}, {half_width, -half_depth}, {half_width, half_depth}, {-half_width, half_depth}};
+
+      // Calculate the vertices starting from bottom-left (anticlockwise)
+      //    Bottom & up Faces
+      for (uint8_t i = 0; i < 4; i++)
+        *vertices++ = Point<T, 3>(center.x() + corners[i][0], center.y() + corners[i][1], center.z() - half_height);
+      for (uint8_t i = 0; i < 4; i++)
+        *vertices++ = Point<T, 3>(center.x() + corners[i][0], center.y() + corners[i][1], center.z() + half_height);
+
+      // Normals to the sides, starting with the bottom side
+      *normals++ = Eigen::Matrix<T, 3, 1>(0, 0, static_cast<T>(-1.0));
+      *normals++ = Eigen::Matrix<T, 3, 1>(0, static_cast<T>(-1.0), 0);
+      *normals++ = Eigen::Matrix<T, 3, 1>(static_cast<T>(1.0), 0, 0);
+      *normals++ = Eigen::Matrix<T, 3, 1>(0, static_cast<T>(1.0), 0);
+      *normals++ = Eigen::Matrix<T, 3, 1>(static_cast<T>(-1.0), 0, 0);
+      *normals++ = Eigen::Matrix<T, 3, 1>(0, 0, static_cast<T>(1.0));
+
+      return {vertices, normals};
+    }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis) override {
+      this->Shape<T, 3>::rotate3D(angle, axis);
+
+      _center = Eigen::AngleAxis<T>(angle, axis) * _center;
+      _width_axis = Eigen::AngleAxis<T>(angle, axis) * _width_axis;
+      _depth_axis = Eigen::AngleAxis<T>(angle, axis) * _depth_axis;
+      _height_axis = Eigen::AngleAxis<T>(angle, axis) * _height_axis;
+    }
+
+    /**
+      * Ray intersection (see Shape::intersect), and its version for packets of W rays
+      */
+    bool intersect(const Ray<T>& ray, T& t) const override { return intersectSingle(*this, ray, t); }
+
+    template <int W>
+    Eigen::Array<bool, W, 1> intersect(const RayPacket<T, W>& rays, Eigen::Array<T, W, 1>& t) const {
+      if (this->scaled()) return intersectMesh(rays, this->cachedMesh([this]{ return this->toMesh(); }), t);
+
+      Eigen::Matrix<T, 3, 3> axes;
+      axes << _width_axis, _depth_axis, _height_axis;
+      Eigen::Matrix<T, 3, 1> half_sizes = Eigen::Matrix<T, 3, 1>(_width, _depth, _height) / static_cast<T>(2.0);
+      return intersectBox(rays, _center, axes, half_sizes, t);
+    }
+
+    /**
+      * Triangle mesh: 4 vertices and 2 triangles per face, with the normal of the face
+      */
+    MeshSize meshSize() const { return MeshSize{24, 36}; }
+
+    template <typename INDEX>
+    void toMesh(T* vertex_buffer, INDEX* index_buffer) const {
+      // Vertices of each face (anticlockwise seen from outside), in the same order as the normals
+      static const uint8_t faces[6][4] { {0, 3, 2, 1}, {0, 1, 5, 4}, {1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7}, {4, 5, 6, 7} };
+
+      MeshWriter<T, INDEX> mesh(meshSize(), vertex_buffer, index_buffer);
+
+      for(uint8_t face = 0; face < 6; face++){
+        INDEX first = mesh.vertex(this->vertices()[faces[face][0]], this->normals()[face]);
+        for(uint8_t i = 1; i < 4; i++)
+          mesh.vertex(this->vertices()[faces[face][i]], this->normals()[face]);
+
+        mesh.triangle(first, first + 1, first + 2);
+        mesh.triangle(first, first + 2, first + 3);
+      }
+    }
+
+    template <typename INDEX = uint32_t>
+    Mesh<T, INDEX> toMesh() const { return makeMesh<T, INDEX>(*this); }
+
+    friend std::ostream& operator<<(std::ostream& os, const Cuboid<T>& cub) {
+      os << "{ *** Cuboid W=" << cub.width() << " D=" << cub.depth() << " H=" << cub.height() << " ***" << std::endl;
+      os << " Center: " << cub.center();
+      auto it = cub.vertices().begin();
+      while(it != cub.vertices().end())
+        os << *(it++);
+      os << "}" << std::endl;
+
+      return os;
+    }
+
+  }; // class Cuboid
+
+} // namespace geo
+
+#undef DEF_WIDTH
+#undef DEF_HEIGHT
+#undef DEF_DEPTH
+
+
+#endif // CUBOID_H
@@ -1,111 +1,183 @@
-#ifndef CYLINDER_H
-#define CYLINDER_H
-
-#include <vector>
-#include <cmath>
-
-#include "../shape.h"
-#include "../Shapes2D/circle.h"
-#include "../point.h"
-
-#define DEF_RADIUS 1
-#define DEF_HEIGHT 1
-#define DEF_NUM_VERTICES 36
-
-namespace geo {
-
-  /** CLASS Cylinder
-    * Template params:
-    *                 T --> type used for the coordinates
-    *
-    * A Cylinder is a 3D figure.
-    * The base circle is centered at the origin
-    * VERTICES ORDER: first the base circle vertices, from x=R, y=0; then the top circle ones, in the same order
-    * Parameters:
-    *            - radius (default = 1)
-    *            - height (default = 1)
-    *            - base_num_vertices (default = 36, 1 vertex per degree in the base circle)
-    */
-
-  template <typename T = float>
-  class Cylinder : public Shape<T, 3>{
-  protected:
-    T _radius;
-    T _height;
-    Point<T, 3> _base_center;
-    Point<T, 3> _top_center;
-    Eigen::Matrix<T, 3, 1> _base_normal;
-    Eigen::Matrix<T, 3, 1> _top_normal;
-
-  public:
-    Cylinder() : Cylinder(DEF_RADIUS, DEF_HEIGHT, Point<T, 3>(), DEF_NUM_VERTICES) {}
-
-    Cylinder(T radius, T height) : Cylinder(radius, height, Point<T, 3>(), DEF_NUM_VERTICES) {}
-
-    Cylinder(T radius, T height, size_t base_num_vertices) : Cylinder(radius, height, Point<T, 3>(), base_num_vertices) {}
-
-    Cylinder(T radius, T height, Point<T, 3> base_center, size_t base_num_vertices = DEF_NUM_VERTICES) :
-            _radius{radius}, _height{height}, _base_center{base_center}, _top_center{Point<T, 3>(base_center.x(), base_center.y(), base_center.z() + height)},
-            _base_normal{-Eigen::Matrix<T, 3, 1>::UnitZ()}, _top_normal{Eigen::Matrix<T, 3, 1>::UnitZ()} {
-      Circle<T> base(radius, _base_center, base_num_vertices);
-      Circle<T> top(radius, _top_center, base_num_vertices);
-
-      // Reserve
-      this->_vertices.resize(base.size() + top.size());
-      this->_normals.resize(this->_vertices.size());
-
-      // Copy data. First 2 vertices are the circle centers
-      for(size_t i = 0; i < base.size(); i++){
-        this->_vertices[i] = base[i];
-        this->_vertices[base.size() + i] = top[i];
-
-        this->_normals[i] = base.normals()[i];
-        this->_normals[base.size() + i] = top.normals()[i];
-      }
-    }
-
-    Cylinder(const Cylinder& c) : Shape<T, 3>(c), _radius{c._radius}, _height{c._height}, _base_center{c._base_center}, _top_center{_top_center} {}
-
-    ~Cylinder(){}
-
-    T radius() const { return _radius; }
-    T height() const { return _height; }
-    const Point<T, 3> & base_center() const { return _base_center; }
-    Eigen::Matrix<T, 3, 1> base_normal() const { return _base_normal; }
-    const Point<T, 3> & top_center() const { return _top_center; }
-    Eigen::Matrix<T, 3, 1> top_normal() const { return _top_normal; }
-
-    T area() const { return Cylinder::area(_radius, _height); }
-    T volume() const { return Cylinder::volume(_radius, _height); }
-    static T area(T radius, T height) { return static_cast<T>(_2PI_) * radius * (radius + height); }
-    static T volume(T radius, T height) { return static_cast<T>(_PI_) * radius * radius * height; }
-
-    virtual void rotate3D(T angle, Eigen::Matrix<T, 3, 1> axis){
-      Shape<T, 3>::rotate3D(angle, axis);
-
-      _base_center = Eigen::AngleAxis<T>(angle, axis) * _base_center;
-      _top_center = Eigen::AngleAxis<T>(angle, axis) * _top_center;
-      _base_normal = Eigen::AngleAxis<T>(angle, axis) * _base_normal;
-      _top_normal = Eigen::AngleAxis<T>(angle, axis) * _top_normal;
-    }
-
-    friend std::ostream& operator<<(std::ostream& os, const Cylinder<T>& c) {
-      os << "{ *** CYLINDER R=" << c.radius() << " H=" << c.height() << " (" << c.size() << " vertices) ***" << std::endl;
-      os << " Base Center: " << c.base_center();
-      os << " Top Center: " << c.top_center();
-      auto it = c._vertices.begin();
-      while(it != c._vertices.end())
-        os << *(it++);
-      os << "}" << std::endl;
-
-      return os;
-    }
-  }; // class Cylinder
-
-} // namespace geo
-
-#undef DEF_RADIUS
-#undef DEF_HEIGHT
-#undef DEF_NUM_VERTICES
-
-#endif // CYLINDER_H
+#ifndef CYLINDER_H
+#define CYLINDER_H
+
+#include <vector>
+#include <cmath>
+
+#include "../constants.h"
+#include "../shape.h"
+#include "../mesh.h"
+#include "../intersection.h"
+#include "../unit_circle.h"
+#include "../point.h"
+
+#define DEF_RADIUS 1
+#define DEF_HEIGHT 1
+#define DEF_NUM_VERTICES 36
+
+namespace geo {
+
+  /** CLASS Cylinder
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * A Cylinder is a 3D figure.
+    * The base circle is centered at the origin
+    * VERTICES ORDER: first the base circle vertices, from x=R, y=0; then the top circle ones, in the same order
+    * Parameters:
+    *            - radius (default = 1)
+    *            - height (default = 1)
+    *            - base_num_vertices (default = 36, 1 vertex per degree in the base circle)
+    */
+
+  template <typename T = float>
+  class Cylinder : public Shape<T, 3>{
+  public:
+    typedef typename Shape<T, 3>::allocator_type allocator_type;
+
+  protected:
+    T _radius;
+    T _height;
+    Point<T, 3> _base_center;
+    Point<T, 3> _top_center;
+    Eigen::Matrix<T, 3, 1> _base_normal;
+    Eigen::Matrix<T, 3, 1> _top_normal;
+
+    bool hasAnalyticBounds() const override { return true; }
+
+    void analyticBounds(Eigen::AlignedBox<T, 3>& aabb, BoundingSphere<T, 3>& sphere) const override {
+      Eigen::Matrix<T, 3, 1> extents = diskExtents(_top_normal, _radius);
+      aabb = Eigen::AlignedBox<T, 3>(_base_center - extents, _base_center + extents);
+      aabb.extend(Eigen::AlignedBox<T, 3>(_top_center - extents, _top_center + extents));
+      sphere.center = (_base_center + _top_center) / static_cast<T>(2.0);
+      sphere.radius = std::sqrt(_radius * _radius + _height * _height / static_cast<T>(4.0));
+    }
+
+  public:
+    Cylinder() : Cylinder(DEF_RADIUS, DEF_HEIGHT, Point<T, 3>(), DEF_NUM_VERTICES) {}
+
+    Cylinder(T radius, T height) : Cylinder(radius, height, Point<T, 3>(), DEF_NUM_VERTICES) {}
+
+    Cylinder(T radius, T height, size_t base_num_vertices) : Cylinder(radius, height, Point<T, 3>(), base_num_vertices) {}
+
+    Cylinder(T radius, T height, Point<T, 3> base_center, size_t base_num_vertices = DEF_NUM_VERTICES, const allocator_type& alloc = {}) :
+            Shape<T, 3>(alloc), _radius{radius}, _height{height}, _base_center{base_center}, _top_center{Point<T, 3>(base_center.x(), base_center.y(), base_center.z() + height)},
+            _base_normal{-Eigen::Matrix<T, 3, 1>::UnitZ()}, _top_normal{Eigen::Matrix<T, 3, 1>::UnitZ()} {
+      GEO_SCOPED_TIMER(SHAPE_CONSTRUCTION);
+      // Reserve
+      this->allocate(2 * base_num_vertices, 2 * base_num_vertices);
+
+      generate(radius, height, base_center, base_num_vertices, this->_vertices.begin(), this->_normals.begin());
+    }
+
+    Cylinder(const Cylinder& c, const allocator_type& alloc = {}) : Shape<T, 3>(c, alloc), _radius{c._radius}, _height{c._height}, _base_center{c._base_center}, _top_center{c._top_center},
+                                  _base_normal{c._base_normal}, _top_normal{c._top_normal} {}
+
+    Cylinder(Cylinder&& c) = default;
+
+    Cylinder& operator=(const Cylinder& c) = default;
+    Cylinder& operator=(Cylinder&& c) = default;
+
+    ~Cylinder(){}
+
+    T radius() const { return _radius; }
+    T height() const { return _height; }
+    const Point<T, 3> & base_center() const { return _base_center; }
+    Eigen::Matrix<T, 3, 1> base_normal() const { return _base_normal; }
+    const Point<T, 3> & top_center() const { return _top_center; }
+    Eigen::Matrix<T, 3, 1> top_normal() const { return _top_normal; }
+
+    T area() const override { return Cylinder::area(_radius, _height); }
+    T volume() const override { return Cylinder::volume(_radius, _height); }
+    static T area(T radius, T height) { return static_cast<T>(_2PI_) * radius * (radius + height); }
+    static T volume(T radius, T height) { return static_cast<T>(_PI_) * radius * radius * height; }
+
+    /**
+      * Writes the 2 * base_num_vertices vertices and normals of a cylinder (the ones of the constructor: base ring, then top ring) into
+      * output iterators, without building the shape. Returns the iterators past the last written elements
+      */
+    template <typename VERTEX_OUT, typename NORMAL_OUT>
+    static std::pair<VERTEX_OUT, NORMAL_OUT> generate(T radius, T height, const Point<T, 3>& base_center, size_t base_num_vertices,
+                                                      VERTEX_OUT vertices, NORMAL_OUT normals) {
+      // Base and top circles share the same unit circle points
+      const std::vector<Eigen::Matrix<T, 2, 1>> & unit = unitCircle<T>(base_num_vertices);
+      for(T z : {base_center.z(), base_center.z() + height}){
+        for(size_t i = 0; i < base_num_vertices; i++){
+          *vertices++ = Point<T, 3>(base_center.x() + radius * unit[i].x(), base_center.y() + radius * unit[i].y(), z);
+          *normals++ = Eigen::Matrix<T, 3, 1>(unit[i].x(), unit[i].y(), 0);
+        }
+      }
+
+      return {vertices, normals};
+    }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis) override {
+      Shape<T, 3>::rotate3D(angle, axis);
+
+      _base_center = Eigen::AngleAxis<T>(angle, axis) * _base_center;
+      _top_center = Eigen::AngleAxis<T>(angle, axis) * _top_center;
+      _base_normal = Eigen::AngleAxis<T>(angle, axis) * _base_normal;
+      _top_normal = Eigen::AngleAxis<T>(angle, axis) * _top_normal;
+    }
+
+    /**
+      * Ray intersection (see Shape::intersect), and its version for packets of W rays
+      */
+    bool intersect(const Ray<T>& ray, T& t) const override { return intersectSingle(*this, ray, t); }
+
+    template <int W>
+    Eigen::Array<bool, W, 1> intersect(const RayPacket<T, W>& rays, Eigen::Array<T, W, 1>& t) const {
+      if (this->scaled()) return intersectMesh(rays, this->cachedMesh([this]{ return this->toMesh(); }), t);
+      return intersectCylinder(rays, _base_center, _top_normal, _radius, _height, t);
+    }
+
+    /**
+      * Triangle mesh: side (vertices with their radial normals) and 2 caps (fans around their centers, with the cap normals)
+      */
+    MeshSize meshSize() const { return MeshSize{4 * (this->size() / 2) + 2, 12 * (this->size() / 2)}; }
+
+    template <typename INDEX>
+    void toMesh(T* vertex_buffer, INDEX* index_buffer) const {
+      MeshWriter<T, INDEX> mesh(meshSize(), vertex_buffer, index_buffer);
+
+      size_t n = this->size() / 2;
+      const Point<T, 3>* base = this->vertices().data();
+      const Point<T, 3>* top = base + n;
+
+      // Side
+      for(size_t i = 0; i < 2 * n; i++)
+        mesh.vertex(this->vertices()[i], this->normals()[i]);
+      for(size_t i = 0; i < n; i++){
+        INDEX next = (i + 1) % n;
+        mesh.triangle(i, next, n + next);
+        mesh.triangle(i, n + next, n + i);
+      }
+
+      // Caps (both rings are anticlockwise seen from the top)
+      mesh.fan(base, n, -MeshWriter<T, INDEX>::polygonNormal(base, n), true);
+      mesh.fan(top, n, MeshWriter<T, INDEX>::polygonNormal(top, n), false);
+    }
+
+    template <typename INDEX = uint32_t>
+    Mesh<T, INDEX> toMesh() const { return makeMesh<T, INDEX>(*this); }
+
+    friend std::ostream& operator<<(std::ostream& os, const Cylinder<T>& c) {
+      os << "{ *** CYLINDER R=" << c.radius() << " H=" << c.height() << " (" << c.size() << " vertices) ***" << std::endl;
+      os << " Base Center: " << c.base_center();
+      os << " Top Center: " << c.top_center();
+      auto it = c.vertices().begin();
+      while(it != c.vertices().end())
+        os << *(it++);
+      os << "}" << std::endl;
+
+      return os;
+    }
+  }; // class Cylinder
+
+} // namespace geo
+
+#undef DEF_RADIUS
+#undef DEF_HEIGHT
+#undef DEF_NUM_VERTICES
+
+#endif // CYLINDER_H
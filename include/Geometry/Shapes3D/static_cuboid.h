@@ -0,0 +1,75 @@
+#ifndef STATIC_CUBOID_H
+#define STATIC_CUBOID_H
+
+#include "../static_shape.h"
+
+#define DEF_WIDTH 1
+#define DEF_HEIGHT 1
+#define DEF_DEPTH 1
+
+namespace geo {
+
+  /** CLASS StaticCuboid
+    * Template params:
+    *                 T --> type used for the coordinates
+    * Fixed-size version of Cuboid (same vertices and normals)
+    * Parameters:
+    *            - width (default = 1)
+    *            - height (default = 1)
+    *            - depth (default = 1)
+    *            - center (default = origin)
+    */
+
+  template <typename T = float>
+  class StaticCuboid : public StaticShape<T, 3, 8, 6>{
+    // Corners of the unit cube: bottom face from bottom-left (anticlockwise), then the up face in the same order
+    static constexpr T _corners[8][3] { {-0.5, -0.5, -0.5}, {0.5, -0.5, -0.5}, {0.5, 0.5, -0.5}, {-0.5, 0.5, -0.5},
+                                        {-0.5, -0.5,  0.5}, {0.5, -0.5,  0.5}, {0.5, 0.5,  0.5}, {-0.5, 0.5,  0.5} };
+    // Normals to the faces: bottom, sides (same order as Rectangle sides), up
+    static constexpr T _face_normals[6][3] { {0, 0, -1}, {0, -1, 0}, {1, 0, 0}, {0, 1, 0}, {-1, 0, 0}, {0, 0, 1} };
+
+  protected:
+    T _width;
+    T _height;
+    T _depth;
+    Point<T, 3> _center;
+
+  public:
+    StaticCuboid() : StaticCuboid(DEF_WIDTH, DEF_HEIGHT, DEF_DEPTH, Point<T, 3>()) {}
+
+    StaticCuboid(T length) : StaticCuboid(length, length, length, Point<T, 3>()) {}
+
+    StaticCuboid(T width, T height, T depth) : StaticCuboid(width, height, depth, Point<T, 3>()) {}
+
+    StaticCuboid(T width /*X*/, T height /*Z*/, T depth /*Y*/, const Point<T, 3>& center) : _width{width}, _height{height}, _depth{depth}, _center{center} {
+      for (uint8_t i = 0; i < 8; i++)
+        this->_vertices[i] = center + Eigen::Matrix<T, 3, 1>(_corners[i][0] * width, _corners[i][1] * depth, _corners[i][2] * height);
+
+      for (uint8_t i = 0; i < 6; i++)
+        this->_normals[i] = Eigen::Matrix<T, 3, 1>(_face_normals[i][0], _face_normals[i][1], _face_normals[i][2]);
+    }
+
+    T width() const { return _width; }
+    T height() const { return _height; }
+    T depth() const { return _depth; }
+
+    const Point<T, 3> & center() const { return _center; }
+
+    T area() const { return static_cast<T>(2.0) * (_width * _depth + _width * _height + _depth * _height); }
+    T volume() const { return _width * _depth * _height; }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis){
+      StaticShape<T, 3, 8, 6>::rotate3D(angle, axis);
+
+      _center = Eigen::AngleAxis<T>(angle, axis) * _center;
+    }
+
+  }; // class StaticCuboid
+
+} // namespace geo
+
+#undef DEF_WIDTH
+#undef DEF_HEIGHT
+#undef DEF_DEPTH
+
+#endif // STATIC_CUBOID_H
@@ -0,0 +1,168 @@
+#ifndef ANCHORED_SHAPE_H
+#define ANCHORED_SHAPE_H
+
+#include <vector>
+
+#include <Eigen/Geometry>
+
+#include "shape.h"
+#include "transformations.h"
+#include "executor.h"
+#include "cartesian_cs_3d.h"
+
+namespace geo {
+
+  /** CLASS AnchoredShape
+    * Template params:
+    *                 T --> type used for the coordinates of the vertices (float)
+    *                 ANCHOR --> type used for the anchor and the transformations (double)
+    *
+    * Mixed precision shape for large worlds: an anchor point in world space kept in ANCHOR precision, and the vertices and normals of a shape
+    * stored in T precision relative to that anchor (small coordinates, so floats do not lose precision far from the origin).
+    * Translations only move the anchor. The buffers for rendering are produced with toLocal(), relative to a camera CartesianCS_3D<ANCHOR>:
+    * the offset from the camera to the anchor is computed in ANCHOR precision, and the vertices are then transformed in T precision.
+    */
+
+  template <typename T = float, typename ANCHOR = double>
+  class AnchoredShape {
+  public:
+    typedef Eigen::Transform<ANCHOR, 3, Eigen::Affine> Transform;
+
+  private:
+    Eigen::Matrix<ANCHOR, 3, 1> _anchor;
+
+    std::vector<Point<T, 3>> _vertices;
+    std::vector<Eigen::Matrix<T, 3, 1>> _normals;
+
+    // Rows: axes of the CS (rotation from world space to the CS)
+    static Eigen::Matrix<T, 3, 3> rotation(const CartesianCS_3D<ANCHOR>& cs) {
+      Eigen::Matrix<T, 3, 3> rotation;
+      for(uint8_t i = 0; i < 3; i++)
+        rotation.row(i) = cs[i].transpose().template cast<T>();
+      return rotation;
+    }
+
+  public:
+    /**
+      * Vertices and normals of a shape built in ANCHOR precision, relative to "anchor"
+      */
+    AnchoredShape(const Shape<ANCHOR, 3>& shape, const Eigen::Matrix<ANCHOR, 3, 1>& anchor) : _anchor{anchor} {
+      _vertices.reserve(shape.vertices().size());
+      for(const Point<ANCHOR, 3>& v : shape.vertices()){
+        Point<T, 3> p;
+        p = (v - anchor).template cast<T>();
+        _vertices.push_back(p);
+      }
+
+      _normals.reserve(shape.normals().size());
+      for(const Eigen::Matrix<ANCHOR, 3, 1>& n : shape.normals())
+        _normals.push_back(n.template cast<T>());
+    }
+
+    /**
+      * Same as above, anchored at the center of the bounding box of the shape
+      */
+    AnchoredShape(const Shape<ANCHOR, 3>& shape) : AnchoredShape(shape, shape.aabb().center()) {}
+
+    ~AnchoredShape() {}
+
+    size_t size() const { return _vertices.size(); }
+
+    const Eigen::Matrix<ANCHOR, 3, 1> & anchor() const { return _anchor; }
+
+    // Vertices and normals relative to the anchor
+    const std::vector<Point<T, 3>> & vertices() const { return _vertices; }
+    const T* data() const { return _vertices.data()->data(); }
+
+    const std::vector<Eigen::Matrix<T, 3, 1>> & normals() const { return _normals; }
+    const T* normalsData() const { return _normals.data()->data(); }
+
+    // Vertex in world space
+    Point<ANCHOR, 3> vertex(size_t pos) const {
+      Point<ANCHOR, 3> p;
+      p = _anchor + _vertices.at(pos).template cast<ANCHOR>();
+      return p;
+    }
+
+    /**
+      * Moves the anchor without moving the shape: the vertices are shifted by the (rounded) offset between both anchors, in one batched addition.
+      *   Useful to keep the vertices small when the shape has moved far from its anchor
+      */
+    void setAnchor(const Eigen::Matrix<ANCHOR, 3, 1>& anchor) {
+      const Eigen::Matrix<T, 3, 1> offset {(_anchor - anchor).template cast<T>()};
+      if (!_vertices.empty())
+        Eigen::Map<Eigen::Matrix<T, 3, Eigen::Dynamic>>(_vertices.data()->data(), 3, _vertices.size()).colwise() += offset;
+      _anchor = anchor;
+    }
+
+    void translate(const Eigen::Matrix<ANCHOR, 3, 1>& translation) { _anchor += translation; }
+
+    /**
+      * Affine transformation in world space: the anchor is transformed in ANCHOR precision, and the vertices and normals with the linear part
+      *   of the matrix (and its inverse-transpose) in T precision
+      */
+    void transform(const Transform& matrix) {
+      GEO_SCOPED_TIMER(TRANSFORM_PASS);
+
+      _anchor = matrix * _anchor;
+
+      Eigen::Transform<T, 3, Eigen::Affine> linear {Eigen::Transform<T, 3, Eigen::Affine>::Identity()};
+      linear.linear() = matrix.linear().template cast<T>();
+      transformPoints(linear, _vertices.data(), _vertices.data() + _vertices.size());
+      transformNormals(Eigen::Matrix<T, 3, 3>(matrix.linear().inverse().transpose().template cast<T>()), _normals.data(), _normals.data() + _normals.size());
+    }
+
+    /**
+      * Same as above, with the vertices and normals split across the threads of the executor
+      */
+    void transform(const Transform& matrix, const Executor& executor) {
+      GEO_SCOPED_TIMER(TRANSFORM_PASS);
+
+      _anchor = matrix * _anchor;
+
+      Eigen::Transform<T, 3, Eigen::Affine> linear {Eigen::Transform<T, 3, Eigen::Affine>::Identity()};
+      linear.linear() = matrix.linear().template cast<T>();
+      transformPoints(executor, linear, _vertices.data(), _vertices.data() + _vertices.size());
+      transformNormals(executor, Eigen::Matrix<T, 3, 3>(matrix.linear().inverse().transpose().template cast<T>()),
+                       _normals.data(), _normals.data() + _normals.size());
+    }
+
+    void scale3D(ANCHOR scale){
+      scale3D(scale, scale, scale);
+    }
+
+    void scale3D(ANCHOR scale_X, ANCHOR scale_Y, ANCHOR scale_Z){
+      transform(Transform(Eigen::Scaling(scale_X, scale_Y, scale_Z)));
+    }
+
+    void rotate3D(ANCHOR angle, const Eigen::Matrix<ANCHOR, 3, 1> & axis) {
+      transform(Transform(Eigen::AngleAxis<ANCHOR>(angle, axis)));
+    }
+
+    /**
+      * Writes the vertices (and normals) in the coordinates of "cs" (e.g. a camera), in T precision. The buffers must have room for size() vertices
+      *   and normals().size() normals
+      */
+    void toLocal(const CartesianCS_3D<ANCHOR>& cs, Point<T, 3>* vertices) const {
+      if (!_vertices.empty()) cs.toLocal(_anchor, data(), _vertices.size(), vertices->data());
+    }
+
+    void toLocal(const CartesianCS_3D<ANCHOR>& cs, Point<T, 3>* vertices, Eigen::Matrix<T, 3, 1>* normals) const {
+      toLocal(cs, vertices);
+      if (!_normals.empty())
+        Eigen::Map<Eigen::Matrix<T, 3, Eigen::Dynamic>>(normals->data(), 3, _normals.size()).noalias() =
+            rotation(cs) * Eigen::Map<const Eigen::Matrix<T, 3, Eigen::Dynamic>>(normalsData(), 3, _normals.size());
+    }
+
+    /**
+      * Same as above, with the vertices split across the threads of the executor
+      */
+    void toLocal(const CartesianCS_3D<ANCHOR>& cs, Point<T, 3>* vertices, const Executor& executor) const {
+      if (!_vertices.empty()) cs.toLocal(executor, _anchor, data(), _vertices.size(), vertices->data());
+    }
+  }; // class AnchoredShape
+
+} // namespace geo
+
+
+#endif // ANCHORED_SHAPE_H
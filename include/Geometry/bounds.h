@@ -0,0 +1,133 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <algorithm>
+#include <cmath>
+
+#include <Eigen/Geometry>
+#include <Eigen/Eigenvalues>
+
+#include "point.h"
+
+namespace geo {
+
+  /** STRUCT BoundingSphere
+    * Template params:
+    *                 T --> type used for the coordinates
+    *                 DIM --> Number of dimensions
+    */
+
+  template <typename T = float, uint8_t DIM = 3>
+  struct BoundingSphere {
+    Point<T, DIM> center;
+    T radius {0};
+  };
+
+
+  /**
+    * Axis-aligned bounding box of "count" points (SIMD min/max reduction over blocks of 8 points)
+    */
+  template <typename T, uint8_t DIM>
+  inline Eigen::AlignedBox<T, DIM> boundingBox(const Point<T, DIM>* points, size_t count);
+
+  /**
+    * Bounding sphere of "count" points, around a given center
+    */
+  template <typename T, uint8_t DIM>
+  inline BoundingSphere<T, DIM> boundingSphere(const Point<T, DIM>* points, size_t count, const Eigen::Matrix<T, int(DIM), 1>& center);
+
+  /**
+    * Axis-aligned box containing the transformed box (exact for boxes, conservative for the shapes they bound)
+    */
+  template <typename T, int DIM>
+  inline Eigen::AlignedBox<T, DIM> transformBox(const Eigen::AlignedBox<T, DIM>& box, const Eigen::Transform<T, DIM, Eigen::Affine>& matrix);
+
+  /**
+    * Sphere containing the transformed sphere: the radius is multiplied by the largest scale factor of the transformation
+    */
+  template <typename T, uint8_t DIM>
+  inline BoundingSphere<T, DIM> transformSphere(const BoundingSphere<T, DIM>& sphere, const Eigen::Transform<T, int(DIM), Eigen::Affine>& matrix);
+
+  /**
+    * Half sizes of the axis-aligned box of a disk, given its normal (normalized) and radius
+    */
+  template <typename T>
+  inline Eigen::Matrix<T, 3, 1> diskExtents(const Eigen::Matrix<T, 3, 1>& normal, T radius);
+
+
+
+
+
+  template <typename T, uint8_t DIM>
+  inline Eigen::AlignedBox<T, DIM> boundingBox(const Point<T, DIM>* points, size_t count){
+    const size_t BLOCK {8};
+
+    Eigen::AlignedBox<T, DIM> box;
+    if (count == 0) return box;
+
+    // Blocks of 8 points are reduced as DIM x 8 values, one per row, so the min/max of the rows are computed with full SIMD registers
+    size_t num_blocks = count / BLOCK;
+    if (num_blocks){
+      Eigen::Map<const Eigen::Matrix<T, DIM * BLOCK, Eigen::Dynamic>> blocks(points->data(), DIM * BLOCK, num_blocks);
+      Eigen::Matrix<T, DIM * BLOCK, 1> block_min = blocks.rowwise().minCoeff();
+      Eigen::Matrix<T, DIM * BLOCK, 1> block_max = blocks.rowwise().maxCoeff();
+      for(size_t i = 0; i < BLOCK; i++){
+        box.extend(Eigen::Matrix<T, DIM, 1>(block_min.template segment<DIM>(i * DIM)));
+        box.extend(Eigen::Matrix<T, DIM, 1>(block_max.template segment<DIM>(i * DIM)));
+      }
+    }
+
+    for(size_t i = num_blocks * BLOCK; i < count; i++)
+      box.extend(points[i]);
+
+    return box;
+  }
+
+
+  template <typename T, uint8_t DIM>
+  inline BoundingSphere<T, DIM> boundingSphere(const Point<T, DIM>* points, size_t count, const Eigen::Matrix<T, int(DIM), 1>& center){
+    BoundingSphere<T, DIM> sphere;
+    sphere.center = center;
+    if (count == 0) return sphere;
+
+    Eigen::Map<const Eigen::Matrix<T, DIM, Eigen::Dynamic>> all(points->data(), DIM, count);
+    sphere.radius = std::sqrt((all.colwise() - center).colwise().squaredNorm().maxCoeff());
+
+    return sphere;
+  }
+
+
+  template <typename T, int DIM>
+  inline Eigen::AlignedBox<T, DIM> transformBox(const Eigen::AlignedBox<T, DIM>& box, const Eigen::Transform<T, DIM, Eigen::Affine>& matrix){
+    if (box.isEmpty()) return box;
+
+    Eigen::Matrix<T, DIM, 1> center = matrix * box.center();
+    Eigen::Matrix<T, DIM, 1> half_sizes = matrix.linear().cwiseAbs() * (box.sizes() / static_cast<T>(2));
+
+    return Eigen::AlignedBox<T, DIM>(center - half_sizes, center + half_sizes);
+  }
+
+
+  template <typename T, uint8_t DIM>
+  inline BoundingSphere<T, DIM> transformSphere(const BoundingSphere<T, DIM>& sphere, const Eigen::Transform<T, int(DIM), Eigen::Affine>& matrix){
+    BoundingSphere<T, DIM> transformed;
+    transformed.center = matrix * sphere.center;
+    transformed.radius = sphere.radius * Eigen::Matrix<T, DIM, DIM>(matrix.linear()).operatorNorm();
+
+    return transformed;
+  }
+
+
+  template <typename T>
+  inline Eigen::Matrix<T, 3, 1> diskExtents(const Eigen::Matrix<T, 3, 1>& normal, T radius){
+    Eigen::Matrix<T, 3, 1> extents;
+    for(uint8_t i = 0; i < 3; i++)
+      extents[i] = radius * std::sqrt(std::max(static_cast<T>(0), static_cast<T>(1) - normal[i] * normal[i]));
+
+    return extents;
+  }
+
+} // namespace geo
+
+
+#endif // BOUNDS_H
@@ -0,0 +1,392 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+#include <Eigen/Geometry>
+
+#include "ray.h"
+#include "shape.h"
+#include "executor.h"
+
+#define DEF_MAX_LEAF_SIZE 4
+
+namespace geo {
+
+  /** CLASS BVH
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * Bounding volume hierarchy over a set of primitives (shapes or any other objects) given by their axis-aligned bounding boxes.
+    * Primitives are identified by their position in the list of bounds used to build the tree.
+    * The tree is built top-down with the surface area heuristic evaluated on 16 bins per axis, and stored as a flat array of 32-byte nodes (with floats)
+    * in depth-first order: the left child of a node is always the next node.
+    * After the primitives move (e.g. with rotate3D/scale3D), refit() updates the boxes without rebuilding the tree.
+    * Parameters:
+    *            - max_leaf_size: maximum number of primitives per leaf (default = 4)
+    */
+
+  template <typename T = float>
+  class BVH {
+  public:
+    /**
+      * Interior nodes (count = 0): the left child is the next node and the right child is at position "offset".
+      * Leaves: primitives in positions [offset, offset + count) of the primitive index list
+      */
+    struct Node {
+      Eigen::AlignedBox<T, 3> box;
+      uint32_t offset;
+      uint32_t count;
+    };
+
+    struct Hit {
+      size_t primitive;
+      T distance;
+    };
+
+    static constexpr size_t NO_HIT {std::numeric_limits<size_t>::max()};
+
+  private:
+    // Bins per axis of the surface area heuristic, and maximum depth of the tree (size of the traversal stacks)
+    static constexpr size_t NUM_BINS {16};
+    static constexpr size_t MAX_DEPTH {64};
+
+    struct Bin {
+      Eigen::AlignedBox<T, 3> box;
+      size_t count {0};
+    };
+
+    size_t _max_leaf_size;
+
+    std::vector<Node> _nodes;
+    std::vector<uint32_t> _indices;
+    std::vector<Eigen::AlignedBox<T, 3>> _bounds;
+
+    // Only used during the build
+    std::vector<Eigen::Matrix<T, 3, 1>> _centroids;
+
+    static T area(const Eigen::AlignedBox<T, 3>& box) {
+      if (box.isEmpty()) return 0;
+
+      Eigen::Matrix<T, 3, 1> sizes = box.sizes();
+      return static_cast<T>(2) * (sizes.x() * sizes.y() + sizes.y() * sizes.z() + sizes.z() * sizes.x());
+    }
+
+    static std::vector<Eigen::AlignedBox<T, 3>> shapeBounds(const std::vector<const Shape<T, 3>*>& shapes) {
+      std::vector<Eigen::AlignedBox<T, 3>> bounds(shapes.size());
+      for(size_t i = 0; i < shapes.size(); i++)
+        bounds[i] = shapes[i]->aabb();
+      return bounds;
+    }
+
+    static size_t bin(T coordinate, T min, T extent) {
+      return std::min(static_cast<size_t>(NUM_BINS * (coordinate - min) / extent), static_cast<size_t>(NUM_BINS - 1));
+    }
+
+    /**
+      * Splits the primitives [first, last) with the surface area heuristic and returns the position of the first primitive of the right child
+      */
+    uint32_t split(uint32_t first, uint32_t last, const Eigen::AlignedBox<T, 3>& centroid_box, const Executor& executor) {
+      Eigen::Matrix<T, 3, 1> extent = centroid_box.sizes();
+
+      int best_axis {-1};
+      size_t best_bin {0};
+      T best_cost {std::numeric_limits<T>::infinity()};
+      for(int axis = 0; axis < 3; axis++){
+        if (extent[axis] <= 0) continue;
+
+        T min = centroid_box.min()[axis];
+        Bin bins[NUM_BINS];
+        std::mutex bins_mutex;
+        executor.parallelFor(last - first, [&](size_t begin, size_t end){
+          Bin local[NUM_BINS];
+          for(size_t i = first + begin; i < first + end; i++){
+            Bin& b = local[bin(_centroids[_indices[i]][axis], min, extent[axis])];
+            b.box.extend(_bounds[_indices[i]]);
+            b.count++;
+          }
+
+          std::lock_guard<std::mutex> lock(bins_mutex);
+          for(size_t b = 0; b < NUM_BINS; b++){
+            bins[b].box.extend(local[b].box);
+            bins[b].count += local[b].count;
+          }
+        });
+
+        // Sweep from the left, then from the right evaluating the cost of splitting after each bin
+        T left_area[NUM_BINS - 1];
+        size_t left_count[NUM_BINS - 1];
+        Eigen::AlignedBox<T, 3> accumulated;
+        size_t count {0};
+        for(size_t b = 0; b < NUM_BINS - 1; b++){
+          accumulated.extend(bins[b].box);
+          count += bins[b].count;
+          left_area[b] = area(accumulated);
+          left_count[b] = count;
+        }
+
+        accumulated.setEmpty();
+        count = 0;
+        for(size_t b = NUM_BINS - 1; b > 0; b--){
+          accumulated.extend(bins[b].box);
+          count += bins[b].count;
+          T cost = left_area[b - 1] * left_count[b - 1] + area(accumulated) * count;
+          if (left_count[b - 1] && count && cost < best_cost){
+            best_cost = cost;
+            best_axis = axis;
+            best_bin = b - 1;
+          }
+        }
+      }
+
+      uint32_t middle = first + (last - first) / 2;
+      if (best_axis < 0){
+        // All the centroids in the same bin: split in 2 halves along the largest axis
+        int axis;
+        extent.maxCoeff(&axis);
+        std::nth_element(_indices.begin() + first, _indices.begin() + middle, _indices.begin() + last,
+                         [&](uint32_t a, uint32_t b){ return _centroids[a][axis] < _centroids[b][axis]; });
+        return middle;
+      }
+
+      T min = centroid_box.min()[best_axis];
+      return std::partition(_indices.begin() + first, _indices.begin() + last,
+                            [&](uint32_t i){ return bin(_centroids[i][best_axis], min, extent[best_axis]) <= best_bin; }) - _indices.begin();
+    }
+
+    uint32_t buildNode(uint32_t first, uint32_t last, size_t depth, const Executor& executor) {
+      uint32_t index = _nodes.size();
+      _nodes.push_back(Node());
+
+      Eigen::AlignedBox<T, 3> box;
+      Eigen::AlignedBox<T, 3> centroid_box;
+      std::mutex box_mutex;
+      executor.parallelFor(last - first, [&](size_t begin, size_t end){
+        Eigen::AlignedBox<T, 3> local_box;
+        Eigen::AlignedBox<T, 3> local_centroids;
+        for(size_t i = first + begin; i < first + end; i++){
+          local_box.extend(_bounds[_indices[i]]);
+          local_centroids.extend(_centroids[_indices[i]]);
+        }
+
+        std::lock_guard<std::mutex> lock(box_mutex);
+        box.extend(local_box);
+        centroid_box.extend(local_centroids);
+      });
+      _nodes[index].box = box;
+
+      if (last - first <= _max_leaf_size || depth == MAX_DEPTH){
+        _nodes[index].offset = first;
+        _nodes[index].count = last - first;
+        return index;
+      }
+
+      uint32_t middle = split(first, last, centroid_box, executor);
+      buildNode(first, middle, depth + 1, executor);
+      uint32_t right = buildNode(middle, last, depth + 1, executor);
+
+      _nodes[index].offset = right;
+      _nodes[index].count = 0;
+      return index;
+    }
+
+  public:
+    BVH(size_t max_leaf_size = DEF_MAX_LEAF_SIZE) : _max_leaf_size{std::max<size_t>(1, max_leaf_size)} {}
+
+    ~BVH() {}
+
+    // Number of primitives
+    size_t size() const { return _bounds.size(); }
+
+    const std::vector<Node> & nodes() const { return _nodes; }
+
+    const Eigen::AlignedBox<T, 3> & bounds(size_t primitive) const { return _bounds.at(primitive); }
+
+    /**
+      * Builds the tree. Bins and boxes of large nodes are computed in parallel by the executor
+      */
+    void build(const std::vector<Eigen::AlignedBox<T, 3>>& bounds, const Executor& executor = SerialExecutor()) {
+      if (bounds.size() > std::numeric_limits<uint32_t>::max())
+        throw std::invalid_argument("Too many primitives.");
+
+      _bounds = bounds;
+      _indices.resize(bounds.size());
+      std::iota(_indices.begin(), _indices.end(), 0);
+
+      _centroids.resize(bounds.size());
+      executor.parallelFor(bounds.size(), [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++)
+          _centroids[i] = _bounds[i].center();
+      });
+
+      _nodes.clear();
+      _nodes.reserve(2 * bounds.size());
+      if (!bounds.empty())
+        buildNode(0, bounds.size(), 0, executor);
+
+      _centroids.clear();
+      _centroids.shrink_to_fit();
+    }
+
+    void build(const std::vector<const Shape<T, 3>*>& shapes, const Executor& executor = SerialExecutor()) {
+      build(shapeBounds(shapes), executor);
+    }
+
+    /**
+      * Updates the boxes of the nodes with new bounds of the same primitives (bottom-up, keeping the tree topology)
+      */
+    void refit(const std::vector<Eigen::AlignedBox<T, 3>>& bounds) {
+      if (bounds.size() != _bounds.size())
+        throw std::invalid_argument("The number of primitives cannot change in a refit.");
+
+      _bounds = bounds;
+
+      // Children are always after their parents
+      for(size_t i = _nodes.size(); i-- > 0;){
+        Node& node = _nodes[i];
+        if (node.count){
+          node.box.setEmpty();
+          for(uint32_t j = node.offset; j < node.offset + node.count; j++)
+            node.box.extend(_bounds[_indices[j]]);
+        }
+        else
+          node.box = _nodes[i + 1].box.merged(_nodes[node.offset].box);
+      }
+    }
+
+    void refit(const std::vector<const Shape<T, 3>*>& shapes) {
+      refit(shapeBounds(shapes));
+    }
+
+    /**
+      * Closest primitive hit by the ray. "intersector(primitive, ray, distance)" must return true, and the distance, if the ray hits the primitive
+      * within [ray.t_min, ray.t_max]. Nodes are visited front to back and ray.t_max shrinks with every hit.
+      */
+    template <typename INTERSECTOR>
+    bool closestHit(const Ray<T>& ray, Hit& hit, INTERSECTOR intersector) const {
+      if (_nodes.empty()) return false;
+
+      Ray<T> r {ray};
+      bool found {false};
+      uint32_t stack[MAX_DEPTH + 1];
+      size_t top {0};
+      T t;
+
+      if (intersect(r, _nodes[0].box, t)) stack[top++] = 0;
+      while(top){
+        uint32_t index = stack[--top];
+        const Node& node = _nodes[index];
+        if (!intersect(r, node.box, t)) continue;
+
+        if (node.count){
+          for(uint32_t i = node.offset; i < node.offset + node.count; i++){
+            if (intersector(static_cast<size_t>(_indices[i]), static_cast<const Ray<T>&>(r), t) && t >= r.t_min && t <= r.t_max){
+              r.t_max = t;
+              hit = Hit{_indices[i], t};
+              found = true;
+            }
+          }
+          continue;
+        }
+
+        T t_left, t_right;
+        bool hit_left = intersect(r, _nodes[index + 1].box, t_left);
+        bool hit_right = intersect(r, _nodes[node.offset].box, t_right);
+        if (hit_left && hit_right){
+          // Nearest child on top of the stack
+          if (t_left <= t_right){
+            stack[top++] = node.offset;
+            stack[top++] = index + 1;
+          }
+          else{
+            stack[top++] = index + 1;
+            stack[top++] = node.offset;
+          }
+        }
+        else if (hit_left)
+          stack[top++] = index + 1;
+        else if (hit_right)
+          stack[top++] = node.offset;
+      }
+
+      return found;
+    }
+
+    /**
+      * Closest primitive bounding box hit by the ray
+      */
+    bool closestHit(const Ray<T>& ray, Hit& hit) const {
+      return closestHit(ray, hit, [&](size_t primitive, const Ray<T>& r, T& t){ return intersect(r, _bounds[primitive], t); });
+    }
+
+    /**
+      * Batched version: one hit per ray (primitive = NO_HIT and infinite distance if the ray misses), with the rays split across the threads of the executor
+      */
+    template <typename INTERSECTOR>
+    void closestHits(const Ray<T>* rays, size_t count, Hit* hits, const Executor& executor, INTERSECTOR intersector) const {
+      executor.parallelFor(count, [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++)
+          if (!closestHit(rays[i], hits[i], intersector))
+            hits[i] = Hit{NO_HIT, std::numeric_limits<T>::infinity()};
+      }, 8 * MAX_DEPTH);
+    }
+
+    void closestHits(const Ray<T>* rays, size_t count, Hit* hits, const Executor& executor = SerialExecutor()) const {
+      closestHits(rays, count, hits, executor, [&](size_t primitive, const Ray<T>& r, T& t){ return intersect(r, _bounds[primitive], t); });
+    }
+
+    /**
+      * Calls "callback(primitive)" for every primitive whose bounding box overlaps the box
+      */
+    template <typename CALLBACK>
+    void forEachOverlap(const Eigen::AlignedBox<T, 3>& box, CALLBACK callback) const {
+      if (_nodes.empty()) return;
+
+      uint32_t stack[MAX_DEPTH + 1];
+      size_t top {0};
+      stack[top++] = 0;
+      while(top){
+        uint32_t index = stack[--top];
+        const Node& node = _nodes[index];
+        if (!node.box.intersects(box)) continue;
+
+        if (node.count){
+          for(uint32_t i = node.offset; i < node.offset + node.count; i++)
+            if (_bounds[_indices[i]].intersects(box))
+              callback(static_cast<size_t>(_indices[i]));
+        }
+        else{
+          stack[top++] = node.offset;
+          stack[top++] = index + 1;
+        }
+      }
+    }
+
+    void overlaps(const Eigen::AlignedBox<T, 3>& box, std::vector<size_t>& primitives) const {
+      forEachOverlap(box, [&](size_t primitive){ primitives.push_back(primitive); });
+    }
+
+    /**
+      * Batched version: primitives overlapping each box, with the boxes split across the threads of the executor
+      */
+    void overlaps(const Eigen::AlignedBox<T, 3>* boxes, size_t count, std::vector<std::vector<size_t>>& primitives, const Executor& executor = SerialExecutor()) const {
+      primitives.resize(count);
+      executor.parallelFor(count, [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++){
+          primitives[i].clear();
+          overlaps(boxes[i], primitives[i]);
+        }
+      }, 8 * MAX_DEPTH);
+    }
+  }; // class BVH
+
+} // namespace geo
+
+#undef DEF_MAX_LEAF_SIZE
+
+#endif // BVH_H
@@ -1,106 +1,204 @@
-#ifndef CARTESIAN_CS_3D_H
-#define CARTESIAN_CS_3D_H
-
-#include <exception>
-#include <limits>
-
-#include <Eigen/Geometry>
-
-namespace geo {
-
-  template <typename T = float>
-  class CartesianCS_3D {
-    std::array<Eigen::Matrix<T, 3, 1>, 3> _axis;
-
-    Eigen::Matrix<T, 3, 1> _center {0, 0, 0};
-
-    Eigen::Matrix<T, 4, 4> transf_matrix {Eigen::Matrix<T, 4, 4>::Identity()};
-  public:
-    /**
-      * Constructor: DEFAULT CARTESIAN COORDINATE SYSTEM
-      */
-    CartesianCS_3D() : _axis{ Eigen::Matrix<T, 3, 1>::UnitX(), Eigen::Matrix<T, 3, 1>::UnitY(), Eigen::Matrix<T, 3, 1>::UnitZ() } {}
-
-    /**
-      * Constructor: ARBITRARY CARTESIAN COORDINATE SYSTEM. Based on 2 given orthogonal vectors (for axis "X" and "Y"). These 2 vectors don't have to be normalized.
-      *   Axis Z is calculated
-      */
-    CartesianCS_3D(const Eigen::Matrix<T, 3, 1>& axis_1, const Eigen::Matrix<T, 3, 1>& axis_2) : CartesianCS_3D(Eigen::Matrix<T, 3, 1>(0, 0, 0), axis_1, axis_2) {}
-
-    /**
-      * Constructor: ARBITRARY CARTESIAN COORDINATE SYSTEM. Based on 2 given orthogonal vectors (for axis "X" and "Y") and a center. These 2 vectors don't have to be normalized.
-      *   Axis Z is calculated
-      */
-    CartesianCS_3D(const Eigen::Matrix<T, 3, 1>& center, const Eigen::Matrix<T, 3, 1>& axis_1, const Eigen::Matrix<T, 3, 1>& axis_2) : _center{center}{
-      _axis[0] = axis_1.normalized();
-      _axis[1] = axis_2.normalized();
-
-      // Validate Orthogonality
-      if( abs(_axis[0].dot(_axis[1])) > static_cast<T>(10.0) * std::numeric_limits<T>::epsilon() )
-        throw std::invalid_argument("Axis vectors must be orthogonal.");
-
-      _axis[2] = _axis[0].cross(_axis[1]);
-
-      // Calculate and store the transformation matrix
-      transf_matrix <<  _axis[0].x(),             _axis[0].y(),             _axis[0].z(),             -_axis[0].dot(_center),
-                        _axis[1].x(),             _axis[1].y(),             _axis[1].z(),             -_axis[1].dot(_center),
-                        _axis[2].x(),             _axis[2].y(),             _axis[2].z(),             -_axis[2].dot(_center),
-                              0,                        0,                        0,                      static_cast<T>(1);
-    }
-
-
-    ~CartesianCS_3D(){};
-
-
-    const Eigen::Matrix<T, 3, 1> & center() const { return _center; }
-
-    const Eigen::Matrix<T, 3, 1> & operator[](uint8_t pos) const { return _axis.at(pos); }
-
-
-    /**
-      * Returns the transformation matrix to go from coordinates in the default CS to this coordinates system.
-      */
-    inline const Eigen::Matrix<T, 4, 4>& transformMatrix() const { return transf_matrix; }
-
-
-    /**
-      * Returns the transformation matrix to go from coordinates in the default CS to coordinates represented by a new CS centered at "position",
-      *     with axis Z in the opposite direction  to "look_at", and axis Y with the orientation determined by "vertical"
-      */
-    static inline Eigen::Matrix<T, 4, 4> transformMatrix(const Eigen::Matrix<T, 3, 1>& position, const Eigen::Matrix<T, 3, 1>& look_at, const Eigen::Matrix<T, 3, 1>& vertical) {
-      Eigen::Matrix<T, 3, 1> newZ = position - look_at;
-      newZ.normalize();
-      Eigen::Matrix<T, 3, 1> newX = vertical.cross(newZ);
-      newX.normalize();
-      Eigen::Matrix<T, 3, 1> newY = newZ.cross(newX);
-
-      return CartesianCS_3D<T>(position, newX, newY).transformMatrix();
-    }
-
-
-    friend std::ostream& operator<<(std::ostream& os, const CartesianCS_3D<T>& cs) {
-      os << "{ " << std::endl;
-      os << "  CENTER: { ";
-      uint8_t i;
-      for(i = 0; i < 2; i++){
-        os << cs._center[i] << ", ";
-      }
-      os << cs._center[i] << " }" << std::endl;
-      for(i = 0; i < 3; i++){
-        os << "  { ";
-        uint8_t j;
-        for(j = 0; j < 2; j++)
-          os << cs[i][j] << ", ";
-        os << cs[i][j] << " }" << std::endl;
-      }
-      os << "}" << std::endl;
-
-      return os;
-    }
-
-  }; // class CartesianCS_3D
-
-} // namespace geo
-
-
-#endif // CARTESIAN_CS_3D_H
+#ifndef CARTESIAN_CS_3D_H
+#define CARTESIAN_CS_3D_H
+
+#include <exception>
+#include <limits>
+
+#include <Eigen/Geometry>
+
+#include "point.h"
+#include "executor.h"
+
+namespace geo {
+
+  template <typename T = float>
+  class CartesianCS_3D {
+    // Mixed precision: the batch transformations of CartesianCS_3D<double> run in CartesianCS_3D<float>
+    template <typename> friend class CartesianCS_3D;
+
+    // Points per matrix product of the batch transformations
+    static constexpr size_t CHUNK_SIZE {256};
+
+    std::array<Eigen::Matrix<T, 3, 1>, 3> _axis;
+
+    Eigen::Matrix<T, 3, 1> _center {0, 0, 0};
+
+    Eigen::Matrix<T, 4, 4> transf_matrix {Eigen::Matrix<T, 4, 4>::Identity()};
+
+    // Affine parts (3x4) of the transformation matrix and of its inverse, to skip the homogeneous coordinate
+    Eigen::Matrix<T, 3, 4> _to_local {Eigen::Matrix<T, 3, 4>::Identity()};
+    Eigen::Matrix<T, 3, 4> _to_global {Eigen::Matrix<T, 3, 4>::Identity()};
+
+    /**
+      * Applies an affine 3x4 matrix to "count" points given as consecutive x, y, z values. "out" can be the same array as "points".
+      *   The points are processed in chunks as 3 x CHUNK_SIZE matrices (one matrix product each), through a buffer which stays in cache
+      */
+    static void affine(const Eigen::Matrix<T, 3, 4>& matrix, const T* points, size_t count, T* out) {
+      Eigen::Matrix<T, 3, CHUNK_SIZE> buffer;
+      for(size_t first = 0; first < count; first += CHUNK_SIZE){
+        size_t size = std::min(CHUNK_SIZE, count - first);
+        Eigen::Map<const Eigen::Matrix<T, 3, Eigen::Dynamic>> in(points + 3 * first, 3, size);
+
+        buffer.leftCols(size).noalias() = matrix.template leftCols<3>() * in;
+        buffer.leftCols(size).colwise() += matrix.col(3);
+        Eigen::Map<Eigen::Matrix<T, 3, Eigen::Dynamic>>(out + 3 * first, 3, size) = buffer.leftCols(size);
+      }
+    }
+
+    static void affine(const Executor& executor, const Eigen::Matrix<T, 3, 4>& matrix, const T* points, size_t count, T* out) {
+      executor.parallelFor(count, [&](size_t first, size_t last){
+        affine(matrix, points + 3 * first, last - first, out + 3 * first);
+      });
+    }
+
+  public:
+    /**
+      * Constructor: DEFAULT CARTESIAN COORDINATE SYSTEM
+      */
+    CartesianCS_3D() : _axis{ Eigen::Matrix<T, 3, 1>::UnitX(), Eigen::Matrix<T, 3, 1>::UnitY(), Eigen::Matrix<T, 3, 1>::UnitZ() } {}
+
+    /**
+      * Constructor: ARBITRARY CARTESIAN COORDINATE SYSTEM. Based on 2 given orthogonal vectors (for axis "X" and "Y"). These 2 vectors don't have to be normalized.
+      *   Axis Z is calculated
+      */
+    CartesianCS_3D(const Eigen::Matrix<T, 3, 1>& axis_1, const Eigen::Matrix<T, 3, 1>& axis_2) : CartesianCS_3D(Eigen::Matrix<T, 3, 1>(0, 0, 0), axis_1, axis_2) {}
+
+    /**
+      * Constructor: ARBITRARY CARTESIAN COORDINATE SYSTEM. Based on 2 given orthogonal vectors (for axis "X" and "Y") and a center. These 2 vectors don't have to be normalized.
+      *   Axis Z is calculated
+      */
+    CartesianCS_3D(const Eigen::Matrix<T, 3, 1>& center, const Eigen::Matrix<T, 3, 1>& axis_1, const Eigen::Matrix<T, 3, 1>& axis_2) : _center{center}{
+      _axis[0] = axis_1.normalized();
+      _axis[1] = axis_2.normalized();
+
+      // Validate Orthogonality
+      if( abs(_axis[0].dot(_axis[1])) > static_cast<T>(10.0) * std::numeric_limits<T>::epsilon() )
+        throw std::invalid_argument("Axis vectors must be orthogonal.");
+
+      _axis[2] = _axis[0].cross(_axis[1]);
+
+      // Calculate and store the transformation matrix
+      transf_matrix <<  _axis[0].x(),             _axis[0].y(),             _axis[0].z(),             -_axis[0].dot(_center),
+                        _axis[1].x(),             _axis[1].y(),             _axis[1].z(),             -_axis[1].dot(_center),
+                        _axis[2].x(),             _axis[2].y(),             _axis[2].z(),             -_axis[2].dot(_center),
+                              0,                        0,                        0,                      static_cast<T>(1);
+
+      // The axes are orthonormal: the inverse rotation is the transpose
+      _to_local = transf_matrix.template topRows<3>();
+      _to_global.template leftCols<3>() = _to_local.template leftCols<3>().transpose();
+      _to_global.col(3) = _center;
+    }
+
+
+    ~CartesianCS_3D(){};
+
+
+    const Eigen::Matrix<T, 3, 1> & center() const { return _center; }
+
+    const Eigen::Matrix<T, 3, 1> & operator[](uint8_t pos) const { return _axis.at(pos); }
+
+
+    /**
+      * Returns the transformation matrix to go from coordinates in the default CS to this coordinates system.
+      */
+    inline const Eigen::Matrix<T, 4, 4>& transformMatrix() const { return transf_matrix; }
+
+
+    /**
+      * Batch transformation of points from the default CS to this CS (toLocal), and back (toGlobal).
+      *   Points are given as spans of Point or as raw arrays of consecutive x, y, z values (e.g. Shape::data()). The output can be the input itself
+      */
+    void toLocal(const T* points, size_t count, T* out) const { affine(_to_local, points, count, out); }
+    void toGlobal(const T* points, size_t count, T* out) const { affine(_to_global, points, count, out); }
+
+    void toLocal(const Point<T, 3>* first, const Point<T, 3>* last, Point<T, 3>* out) const {
+      if (first != last) toLocal(first->data(), last - first, out->data());
+    }
+
+    void toGlobal(const Point<T, 3>* first, const Point<T, 3>* last, Point<T, 3>* out) const {
+      if (first != last) toGlobal(first->data(), last - first, out->data());
+    }
+
+    /**
+      * Same as above, with the points split across the threads of the executor
+      */
+    void toLocal(const Executor& executor, const T* points, size_t count, T* out) const { affine(executor, _to_local, points, count, out); }
+    void toGlobal(const Executor& executor, const T* points, size_t count, T* out) const { affine(executor, _to_global, points, count, out); }
+
+    void toLocal(const Executor& executor, const Point<T, 3>* first, const Point<T, 3>* last, Point<T, 3>* out) const {
+      if (first != last) toLocal(executor, first->data(), last - first, out->data());
+    }
+
+    void toGlobal(const Executor& executor, const Point<T, 3>* first, const Point<T, 3>* last, Point<T, 3>* out) const {
+      if (first != last) toGlobal(executor, first->data(), last - first, out->data());
+    }
+
+
+    /**
+      * Affine part (3x4) of the transformation to this CS of points given relative to "anchor". It is computed in T and then rounded to LOW:
+      *   with T = double and LOW = float, only the rotation and the offset from the center to the anchor are rounded, not the (large) coordinates
+      *   of the anchor or of the center
+      */
+    template <typename LOW>
+    Eigen::Matrix<LOW, 3, 4> toLocalMatrix(const Eigen::Matrix<T, 3, 1>& anchor) const {
+      Eigen::Matrix<T, 3, 4> matrix;
+      matrix.template leftCols<3>() = _to_local.template leftCols<3>();
+      matrix.col(3) = _to_local.template leftCols<3>() * (anchor - _center);
+      return matrix.template cast<LOW>();
+    }
+
+    /**
+      * Batch transformation to this CS of "count" points given relative to "anchor" (e.g. the float vertices of an AnchoredShape), in LOW precision
+      */
+    template <typename LOW>
+    void toLocal(const Eigen::Matrix<T, 3, 1>& anchor, const LOW* points, size_t count, LOW* out) const {
+      CartesianCS_3D<LOW>::affine(toLocalMatrix<LOW>(anchor), points, count, out);
+    }
+
+    template <typename LOW>
+    void toLocal(const Executor& executor, const Eigen::Matrix<T, 3, 1>& anchor, const LOW* points, size_t count, LOW* out) const {
+      CartesianCS_3D<LOW>::affine(executor, toLocalMatrix<LOW>(anchor), points, count, out);
+    }
+
+
+    /**
+      * Returns the transformation matrix to go from coordinates in the default CS to coordinates represented by a new CS centered at "position",
+      *     with axis Z in the opposite direction  to "look_at", and axis Y with the orientation determined by "vertical"
+      */
+    static inline Eigen::Matrix<T, 4, 4> transformMatrix(const Eigen::Matrix<T, 3, 1>& position, const Eigen::Matrix<T, 3, 1>& look_at, const Eigen::Matrix<T, 3, 1>& vertical) {
+      Eigen::Matrix<T, 3, 1> newZ = position - look_at;
+      newZ.normalize();
+      Eigen::Matrix<T, 3, 1> newX = vertical.cross(newZ);
+      newX.normalize();
+      Eigen::Matrix<T, 3, 1> newY = newZ.cross(newX);
+
+      return CartesianCS_3D<T>(position, newX, newY).transformMatrix();
+    }
+
+
+    friend std::ostream& operator<<(std::ostream& os, const CartesianCS_3D<T>& cs) {
+      os << "{ " << std::endl;
+      os << "  CENTER: { ";
+      uint8_t i;
+      for(i = 0; i < 2; i++){
+        os << cs._center[i] << ", ";
+      }
+      os << cs._center[i] << " }" << std::endl;
+      for(i = 0; i < 3; i++){
+        os << "  { ";
+        uint8_t j;
+        for(j = 0; j < 2; j++)
+          os << cs[i][j] << ", ";
+        os << cs[i][j] << " }" << std::endl;
+      }
+      os << "}" << std::endl;
+
+      return os;
+    }
+
+  }; // class CartesianCS_3D
+
+} // namespace geo
+
+
+#endif // CARTESIAN_CS_3D_H
@@ -1,10 +1,10 @@
-#ifndef CONSTANTS_H_INCLUDED
-#define CONSTANTS_H_INCLUDED
-
-constexpr double _PI_       {3.141592653589793};
-constexpr double _HALF_PI_  {1.570796326794896};
-constexpr double _2PI_      {6.283185307179586};
-constexpr double _RAD_2_DEG {57.29577951308232};
-
-
-#endif // CONSTANTS_H_INCLUDED
+#ifndef CONSTANTS_H_INCLUDED
+#define CONSTANTS_H_INCLUDED
+
+constexpr double _PI_       {3.141592653589793};
+constexpr double _HALF_PI_  {1.570796326794896};
+constexpr double _2PI_      {6.283185307179586};
+constexpr double _RAD_2_DEG {57.29577951308232};
+
+
+#endif // CONSTANTS_H_INCLUDED
@@ -0,0 +1,168 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define DEF_THRESHOLD 16384
+
+namespace geo {
+
+  /** ABSTRACT CLASS Executor
+    * Runs loops over [0, count), split in ranges [first, last) which can be processed concurrently.
+    * Parameters:
+    *            - threshold: loops whose cost (number of iterations x cost of one iteration, e.g. number of vertices) is below it run serially
+    *                         in the calling thread (default = 16384)
+    */
+
+  class Executor {
+    size_t _threshold;
+
+  public:
+    typedef std::function<void(size_t first, size_t last)> Task;
+
+    Executor(size_t threshold = DEF_THRESHOLD) : _threshold{threshold} {}
+
+    virtual ~Executor(){}
+
+    size_t threshold() const { return _threshold; }
+
+    /**
+      * Runs the task over [0, count) and returns when all the ranges have been processed.
+      *   cost: approximate cost of one iteration, in the same unit as the threshold
+      */
+    virtual void parallelFor(size_t count, const Task& task, size_t cost = 1) const = 0;
+  }; // class Executor
+
+
+  /** CLASS SerialExecutor
+    * Runs the whole loop in the calling thread
+    */
+
+  class SerialExecutor : public Executor {
+  public:
+    SerialExecutor() : Executor(0) {}
+
+    void parallelFor(size_t count, const Task& task, size_t = 1) const {
+      if (count) task(0, count);
+    }
+  }; // class SerialExecutor
+
+
+  /** CLASS ThreadPool
+    * Runs loops on a fixed set of worker threads plus the calling thread.
+    * The loop is split in chunks (several per thread), which are claimed dynamically by the threads as they become idle, so uneven ranges are balanced.
+    * Tasks must not throw.
+    * Parameters:
+    *            - num_threads: total number of threads, including the calling one (default = hardware concurrency)
+    *            - threshold: see Executor
+    */
+
+  class ThreadPool : public Executor {
+    struct Job {
+      const Task* task;
+      size_t count;
+      size_t chunk;
+      std::atomic<size_t> next {0};
+      std::atomic<size_t> remaining;
+    };
+
+    std::vector<std::thread> _workers;
+
+    // Serializes loops submitted concurrently from different threads
+    mutable std::mutex _submit_mutex;
+
+    mutable std::mutex _mutex;
+    mutable std::condition_variable _job_cv;
+    mutable std::condition_variable _done_cv;
+    mutable std::shared_ptr<Job> _job;
+    mutable uint64_t _generation {0};
+    bool _stop {false};
+
+    void runChunks(Job& job) const {
+      size_t first;
+      while((first = job.next.fetch_add(job.chunk)) < job.count){
+        (*job.task)(first, std::min(first + job.chunk, job.count));
+
+        if (job.remaining.fetch_sub(1) == 1){
+          std::lock_guard<std::mutex> lock(_mutex);
+          _done_cv.notify_all();
+        }
+      }
+    }
+
+    void workerLoop() {
+      uint64_t generation {0};
+      std::unique_lock<std::mutex> lock(_mutex);
+      while(true){
+        _job_cv.wait(lock, [&]{ return _stop || _generation != generation; });
+        if (_stop) return;
+
+        generation = _generation;
+        std::shared_ptr<Job> job = _job;
+        lock.unlock();
+        runChunks(*job);
+        lock.lock();
+      }
+    }
+
+  public:
+    ThreadPool(size_t num_threads = std::thread::hardware_concurrency(), size_t threshold = DEF_THRESHOLD) : Executor(threshold) {
+      for(size_t i = 1; i < num_threads; i++)
+        _workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool(){
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+      }
+      _job_cv.notify_all();
+      for(std::thread& worker : _workers)
+        worker.join();
+    }
+
+    size_t size() const { return _workers.size() + 1; }
+
+    void parallelFor(size_t count, const Task& task, size_t cost = 1) const {
+      if (count == 0) return;
+      if (_workers.empty() || count * cost < threshold()){
+        task(0, count);
+        return;
+      }
+
+      std::lock_guard<std::mutex> submit(_submit_mutex);
+
+      std::shared_ptr<Job> job = std::make_shared<Job>();
+      job->task = &task;
+      job->count = count;
+      job->chunk = std::max<size_t>(1, count / (4 * size()));
+      job->remaining = (count + job->chunk - 1) / job->chunk;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _job = job;
+        _generation++;
+      }
+      _job_cv.notify_all();
+
+      runChunks(*job);
+
+      std::unique_lock<std::mutex> lock(_mutex);
+      _done_cv.wait(lock, [&]{ return job->remaining == 0; });
+    }
+  }; // class ThreadPool
+
+} // namespace geo
+
+#undef DEF_THRESHOLD
+
+#endif // EXECUTOR_H
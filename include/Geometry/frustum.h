@@ -0,0 +1,205 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <vector>
+#include <cstring>
+
+#include <Eigen/Geometry>
+
+#include "bounds.h"
+#include "executor.h"
+
+namespace geo {
+
+  /** CLASS Frustum
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * View frustum extracted from a view-projection matrix (projection * view, e.g. perspectiveProjection or orthoProjection times the matrix
+    * given by CartesianCS_3D::transformMatrix), with clip space depth in [0, 1] as produced by those projections.
+    * The 6 planes are normalized, with their normals pointing to the inside.
+    * Bounds are culled 8 at a time: every plane is tested against the centers of 8 objects with one SIMD operation,
+    * and the indices of the visible ones are written out compacted, in increasing order.
+    * All the methods are const: several threads can cull with the same frustum at once.
+    */
+
+  template <typename T = float>
+  class Frustum {
+  public:
+    enum Plane { LEFT_PLANE = 0, RIGHT_PLANE, BOTTOM_PLANE, TOP_PLANE, NEAR_PLANE, FAR_PLANE };
+
+  private:
+    // Objects tested at once, and objects per parallel task
+    static constexpr int CULL_LANES {8};
+    static constexpr size_t CULL_BLOCK_SIZE {4096};
+
+    // One plane per row: normal (x, y, z) and distance to the origin
+    Eigen::Matrix<T, 6, 4> _planes;
+
+    typedef Eigen::Array<T, CULL_LANES, 1> Lanes;
+    typedef Eigen::Array<T, CULL_LANES, 3> Centers;
+
+    /**
+      * Culls [first, last) and writes the visible indices to "visible". Returns their number
+      */
+    size_t cullRange(const BoundingSphere<T, 3>* spheres, size_t first, size_t last, uint32_t* visible) const {
+      size_t num_visible {0};
+      size_t i {first};
+      for(; i + CULL_LANES <= last; i += CULL_LANES){
+        Centers centers;
+        Lanes radii;
+        for(int k = 0; k < CULL_LANES; k++){
+          centers.row(k) = spheres[i + k].center.transpose().array();
+          radii[k] = spheres[i + k].radius;
+        }
+
+        Eigen::Array<bool, CULL_LANES, 1> inside {Eigen::Array<bool, CULL_LANES, 1>::Constant(true)};
+        for(uint8_t p = 0; p < 6; p++)
+          inside = inside && ((centers.matrix() * _planes.template block<1, 3>(p, 0).transpose()).array() + _planes(p, 3) >= -radii);
+
+        // Branchless compaction
+        for(int k = 0; k < CULL_LANES; k++){
+          visible[num_visible] = i + k;
+          num_visible += inside[k];
+        }
+      }
+
+      for(; i < last; i++)
+        if (isVisible(spheres[i]))
+          visible[num_visible++] = i;
+
+      return num_visible;
+    }
+
+    size_t cullRange(const Eigen::AlignedBox<T, 3>* boxes, size_t first, size_t last, uint32_t* visible) const {
+      Eigen::Matrix<T, 6, 3> abs_normals = _planes.template leftCols<3>().cwiseAbs();
+
+      size_t num_visible {0};
+      size_t i {first};
+      for(; i + CULL_LANES <= last; i += CULL_LANES){
+        Centers centers;
+        Centers half_sizes;
+        for(int k = 0; k < CULL_LANES; k++){
+          centers.row(k) = boxes[i + k].center().transpose().array();
+          half_sizes.row(k) = (boxes[i + k].sizes() / static_cast<T>(2)).transpose().array();
+        }
+
+        // The box is outside a plane if its corner furthest along the normal is
+        Eigen::Array<bool, CULL_LANES, 1> inside {Eigen::Array<bool, CULL_LANES, 1>::Constant(true)};
+        for(uint8_t p = 0; p < 6; p++)
+          inside = inside && ((centers.matrix() * _planes.template block<1, 3>(p, 0).transpose()).array() + _planes(p, 3)
+                              + (half_sizes.matrix() * abs_normals.row(p).transpose()).array() >= 0);
+
+        for(int k = 0; k < CULL_LANES; k++){
+          visible[num_visible] = i + k;
+          num_visible += inside[k];
+        }
+      }
+
+      for(; i < last; i++)
+        if (isVisible(boxes[i]))
+          visible[num_visible++] = i;
+
+      return num_visible;
+    }
+
+    /**
+      * Blocks of CULL_BLOCK_SIZE objects are culled in parallel, each one into its own part of "visible", and then moved down to be contiguous
+      */
+    template <typename BOUNDS>
+    size_t cullBlocks(const BOUNDS* bounds, size_t count, uint32_t* visible, const Executor& executor) const {
+      size_t num_blocks = (count + CULL_BLOCK_SIZE - 1) / CULL_BLOCK_SIZE;
+      std::vector<size_t> block_visible(num_blocks);
+
+      executor.parallelFor(num_blocks, [&](size_t first, size_t last){
+        for(size_t b = first; b < last; b++)
+          block_visible[b] = cullRange(bounds, b * CULL_BLOCK_SIZE, std::min((b + 1) * CULL_BLOCK_SIZE, count), visible + b * CULL_BLOCK_SIZE);
+      }, CULL_BLOCK_SIZE);
+
+      size_t num_visible {0};
+      for(size_t b = 0; b < num_blocks; b++){
+        if (num_visible != b * CULL_BLOCK_SIZE)
+          std::memmove(visible + num_visible, visible + b * CULL_BLOCK_SIZE, block_visible[b] * sizeof(uint32_t));
+        num_visible += block_visible[b];
+      }
+
+      return num_visible;
+    }
+
+  public:
+    Frustum(const Eigen::Matrix<T, 4, 4>& view_projection) {
+      // Clip space: -w <= x <= w, -w <= y <= w, 0 <= z <= w
+      _planes.row(LEFT_PLANE) = view_projection.row(3) + view_projection.row(0);
+      _planes.row(RIGHT_PLANE) = view_projection.row(3) - view_projection.row(0);
+      _planes.row(BOTTOM_PLANE) = view_projection.row(3) + view_projection.row(1);
+      _planes.row(TOP_PLANE) = view_projection.row(3) - view_projection.row(1);
+      _planes.row(NEAR_PLANE) = view_projection.row(2);
+      _planes.row(FAR_PLANE) = view_projection.row(3) - view_projection.row(2);
+
+      for(uint8_t p = 0; p < 6; p++)
+        _planes.row(p) /= _planes.template block<1, 3>(p, 0).norm();
+    }
+
+    Frustum(const Frustum& f) : _planes{f._planes} {}
+
+    ~Frustum() {}
+
+    const Eigen::Matrix<T, 6, 4> & planes() const { return _planes; }
+
+    /**
+      * Signed distance from a point to one of the planes (positive inside)
+      */
+    T distance(Plane plane, const Eigen::Matrix<T, 3, 1>& point) const {
+      return _planes.template block<1, 3>(plane, 0).dot(point.transpose()) + _planes(plane, 3);
+    }
+
+    bool isVisible(const BoundingSphere<T, 3>& sphere) const {
+      return ((_planes.template leftCols<3>() * sphere.center).array() + _planes.col(3).array() >= -sphere.radius).all();
+    }
+
+    bool isVisible(const Eigen::AlignedBox<T, 3>& box) const {
+      Eigen::Matrix<T, 3, 1> half_sizes = box.sizes() / static_cast<T>(2);
+      return ((_planes.template leftCols<3>() * box.center()).array() + _planes.col(3).array()
+              + (_planes.template leftCols<3>().cwiseAbs() * half_sizes).array() >= 0).all();
+    }
+
+    /**
+      * Writes the indices of the visible objects to "visible" (which must have room for "count" indices), and returns their number.
+      * Conservative: objects near the corners of the frustum may be reported as visible
+      */
+    size_t cull(const BoundingSphere<T, 3>* spheres, size_t count, uint32_t* visible) const {
+      return cullRange(spheres, 0, count, visible);
+    }
+
+    size_t cull(const Eigen::AlignedBox<T, 3>* boxes, size_t count, uint32_t* visible) const {
+      return cullRange(boxes, 0, count, visible);
+    }
+
+    /**
+      * Same as above, with the objects split across the threads of the executor
+      */
+    size_t cull(const BoundingSphere<T, 3>* spheres, size_t count, uint32_t* visible, const Executor& executor) const {
+      return cullBlocks(spheres, count, visible, executor);
+    }
+
+    size_t cull(const Eigen::AlignedBox<T, 3>* boxes, size_t count, uint32_t* visible, const Executor& executor) const {
+      return cullBlocks(boxes, count, visible, executor);
+    }
+
+    size_t cull(const std::vector<BoundingSphere<T, 3>>& spheres, std::vector<uint32_t>& visible, const Executor& executor = SerialExecutor()) const {
+      visible.resize(spheres.size());
+      visible.resize(cull(spheres.data(), spheres.size(), visible.data(), executor));
+      return visible.size();
+    }
+
+    size_t cull(const std::vector<Eigen::AlignedBox<T, 3>>& boxes, std::vector<uint32_t>& visible, const Executor& executor = SerialExecutor()) const {
+      visible.resize(boxes.size());
+      visible.resize(cull(boxes.data(), boxes.size(), visible.data(), executor));
+      return visible.size();
+    }
+  }; // class Frustum
+
+} // namespace geo
+
+
+#endif // FRUSTUM_H
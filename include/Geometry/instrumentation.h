@@ -0,0 +1,258 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+/**
+  * Opt-in instrumentation of the hot paths of the library, enabled by defining GEOMETRY_INSTRUMENTATION (CMake option of the same name).
+  *   GEO_SCOPED_TIMER(metric): times the enclosing scope
+  *   GEO_COUNT(metric, value): adds a value to a counter
+  * When it is not defined both macros expand to nothing, so the instrumented code is exactly the code without instrumentation.
+  */
+
+#ifndef GEOMETRY_INSTRUMENTATION
+
+#define GEO_SCOPED_TIMER(metric)
+#define GEO_COUNT(metric, value)
+
+#else
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#define GEO_CONCAT_(a, b) a##b
+#define GEO_CONCAT(a, b) GEO_CONCAT_(a, b)
+#define GEO_SCOPED_TIMER(metric) geo::ScopedTimer GEO_CONCAT(geo_scoped_timer_, __LINE__)(geo::Metric::metric)
+#define GEO_COUNT(metric, value) geo::Instrumentation::count(geo::Metric::metric, static_cast<uint64_t>(value))
+
+namespace geo {
+
+  /**
+    * Timers: SHAPE_CONSTRUCTION, TRANSFORM_PASS. Counters: the rest.
+    * BUFFER_REQUESTS and BYTES_REQUESTED count the vertex and normal buffers requested by the constructors of the shapes, and their sizes.
+    * They are not heap allocations: copies, meshes and batches are not counted, and the memory resource of the shape (e.g. a monotonic or
+    * pool resource) may serve many requests with one allocation
+    */
+  enum class Metric : uint8_t { SHAPE_CONSTRUCTION = 0, TRANSFORM_PASS, BUFFER_REQUESTS, BYTES_REQUESTED, VERTICES_PROCESSED, NUM_METRICS };
+
+
+  /** STRUCT MetricStats
+    * Timers: number of calls, total and maximum time (nanoseconds). Counters: number of updates, sum and maximum of the values
+    */
+
+  struct MetricStats {
+    uint64_t count {0};
+    uint64_t total {0};
+    uint64_t max {0};
+
+    void add(const MetricStats& s) {
+      count += s.count;
+      total += s.total;
+      if (s.max > max) max = s.max;
+    }
+  };
+
+
+  /** CLASS Instrumentation
+    * Per-thread aggregation: every thread updates its own record (relaxed atomics written by that thread only, no contention),
+    * and snapshots add up the records of all the threads, including the ones which have finished.
+    * Timed scopes can also be recorded as trace events (enableTrace), to be written as Chrome trace JSON (chrome://tracing, Perfetto).
+    */
+
+  class Instrumentation {
+  public:
+    static constexpr size_t NUM_METRICS {static_cast<size_t>(Metric::NUM_METRICS)};
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Snapshot {
+      std::array<MetricStats, NUM_METRICS> totals;
+      std::vector<std::array<MetricStats, NUM_METRICS>> threads;
+
+      const MetricStats & operator[](Metric metric) const { return totals[static_cast<size_t>(metric)]; }
+    };
+
+  private:
+    struct TraceEvent {
+      Metric metric;
+      uint64_t start;
+      uint64_t duration;
+    };
+
+    struct ThreadRecord {
+      uint32_t thread_id;
+      std::array<std::atomic<uint64_t>, NUM_METRICS> count {};
+      std::array<std::atomic<uint64_t>, NUM_METRICS> total {};
+      std::array<std::atomic<uint64_t>, NUM_METRICS> max {};
+
+      std::mutex trace_mutex;
+      std::vector<TraceEvent> trace;
+
+      void add(size_t m, uint64_t value) {
+        count[m].store(count[m].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total[m].store(total[m].load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        if (value > max[m].load(std::memory_order_relaxed))
+          max[m].store(value, std::memory_order_relaxed);
+      }
+    };
+
+    struct Registry {
+      std::mutex mutex;
+      std::vector<std::shared_ptr<ThreadRecord>> records;
+      std::atomic<bool> tracing {false};
+      Clock::time_point origin {Clock::now()};
+    };
+
+    static Registry& registry() {
+      static Registry registry;
+      return registry;
+    }
+
+    static ThreadRecord& local() {
+      thread_local std::shared_ptr<ThreadRecord> record = []{
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.records.push_back(std::make_shared<ThreadRecord>());
+        r.records.back()->thread_id = r.records.size() - 1;
+        return r.records.back();
+      }();
+
+      return *record;
+    }
+
+  public:
+    static const char* name(Metric metric) {
+      static const char* names[NUM_METRICS] {"shape_construction", "transform_pass", "buffer_requests", "bytes_requested", "vertices_processed"};
+      return names[static_cast<size_t>(metric)];
+    }
+
+    static bool isTimer(Metric metric) { return metric == Metric::SHAPE_CONSTRUCTION || metric == Metric::TRANSFORM_PASS; }
+
+    static void count(Metric metric, uint64_t value) { local().add(static_cast<size_t>(metric), value); }
+
+    static void time(Metric metric, Clock::time_point start, Clock::time_point end) {
+      ThreadRecord& record = local();
+      uint64_t duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+      record.add(static_cast<size_t>(metric), duration);
+
+      if (registry().tracing.load(std::memory_order_relaxed)){
+        uint64_t offset = std::chrono::duration_cast<std::chrono::nanoseconds>(start - registry().origin).count();
+        std::lock_guard<std::mutex> lock(record.trace_mutex);
+        record.trace.push_back(TraceEvent{metric, offset, duration});
+      }
+    }
+
+    /**
+      * Records timed scopes as trace events from now on (or stops recording them)
+      */
+    static void enableTrace(bool enabled) { registry().tracing = enabled; }
+
+    static Snapshot snapshot() {
+      Registry& r = registry();
+      std::lock_guard<std::mutex> lock(r.mutex);
+
+      Snapshot snapshot;
+      for(const std::shared_ptr<ThreadRecord>& record : r.records){
+        std::array<MetricStats, NUM_METRICS> thread;
+        for(size_t m = 0; m < NUM_METRICS; m++){
+          thread[m].count = record->count[m].load(std::memory_order_relaxed);
+          thread[m].total = record->total[m].load(std::memory_order_relaxed);
+          thread[m].max = record->max[m].load(std::memory_order_relaxed);
+          snapshot.totals[m].add(thread[m]);
+        }
+        snapshot.threads.push_back(thread);
+      }
+
+      return snapshot;
+    }
+
+    /**
+      * Clears counters, timers and trace events. Updates made by other threads at the same time may be lost
+      */
+    static void reset() {
+      Registry& r = registry();
+      std::lock_guard<std::mutex> lock(r.mutex);
+      for(const std::shared_ptr<ThreadRecord>& record : r.records){
+        for(size_t m = 0; m < NUM_METRICS; m++){
+          record->count[m].store(0, std::memory_order_relaxed);
+          record->total[m].store(0, std::memory_order_relaxed);
+          record->max[m].store(0, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> trace_lock(record->trace_mutex);
+        record->trace.clear();
+      }
+    }
+
+    /**
+      * Totals of all the threads, one line per metric
+      */
+    static void dump(std::ostream& os) {
+      Snapshot s = snapshot();
+      for(size_t m = 0; m < NUM_METRICS; m++){
+        Metric metric = static_cast<Metric>(m);
+        os << name(metric) << ": count=" << s.totals[m].count;
+        if (isTimer(metric))
+          os << " total_ns=" << s.totals[m].total << " max_ns=" << s.totals[m].max;
+        else
+          os << " sum=" << s.totals[m].total << " max=" << s.totals[m].max;
+        os << std::endl;
+      }
+    }
+
+    /**
+      * Trace events in Chrome trace JSON format (complete events, times in microseconds)
+      */
+    static void writeChromeTrace(std::ostream& os) {
+      Registry& r = registry();
+      std::lock_guard<std::mutex> lock(r.mutex);
+
+      std::ios_base::fmtflags flags = os.flags();
+      std::streamsize precision = os.precision();
+      os << std::fixed << std::setprecision(3);
+
+      os << "{\"traceEvents\":[";
+      bool first {true};
+      for(const std::shared_ptr<ThreadRecord>& record : r.records){
+        std::lock_guard<std::mutex> trace_lock(record->trace_mutex);
+        for(const TraceEvent& event : record->trace){
+          os << (first ? "" : ",") << std::endl;
+          os << "{\"name\":\"" << name(event.metric) << "\",\"cat\":\"geometry\",\"ph\":\"X\",\"pid\":0,\"tid\":" << record->thread_id
+             << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+          first = false;
+        }
+      }
+      os << std::endl << "]}" << std::endl;
+
+      os.flags(flags);
+      os.precision(precision);
+    }
+  }; // class Instrumentation
+
+
+  /** CLASS ScopedTimer
+    * Records the time from its construction to its destruction
+    */
+
+  class ScopedTimer {
+    Metric _metric;
+    Instrumentation::Clock::time_point _start;
+
+  public:
+    ScopedTimer(Metric metric) : _metric{metric}, _start{Instrumentation::Clock::now()} {}
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() { Instrumentation::time(_metric, _start, Instrumentation::Clock::now()); }
+  }; // class ScopedTimer
+
+} // namespace geo
+
+#endif // GEOMETRY_INSTRUMENTATION
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,286 @@
+#ifndef INTERSECTION_H
+#define INTERSECTION_H
+
+#include <cmath>
+#include <limits>
+
+#include <Eigen/Geometry>
+
+#include "ray.h"
+#include "mesh.h"
+
+namespace geo {
+
+  /**
+    * Analytic ray - shape intersection kernels, on packets of W rays (a single ray is a packet with W = 1).
+    * Each kernel returns the mask of the rays which hit the shape within [t_min, t_max], and their distance to the first hit in "t"
+    * (the values of the other lanes are undefined). Axes must be normalized.
+    */
+
+  /**
+    * Disk with the given center, normal and radius
+    */
+  template <typename T, int W>
+  inline Eigen::Array<bool, W, 1> intersectDisk(const RayPacket<T, W>& rays, const Eigen::Matrix<T, 3, 1>& center, const Eigen::Matrix<T, 3, 1>& normal, T radius,
+                                                Eigen::Array<T, W, 1>& t);
+
+  /**
+    * Rectangle with the given center, and half sizes along its 2 (orthogonal) axes
+    */
+  template <typename T, int W>
+  inline Eigen::Array<bool, W, 1> intersectRectangle(const RayPacket<T, W>& rays, const Eigen::Matrix<T, 3, 1>& center,
+                                                     const Eigen::Matrix<T, 3, 1>& axis_u, const Eigen::Matrix<T, 3, 1>& axis_v, T half_u, T half_v,
+                                                     Eigen::Array<T, W, 1>& t);
+
+  /**
+    * Oriented box with the given center, axes (columns of a rotation matrix) and half sizes along them.
+    * The box is a solid: a ray starting inside hits it where it leaves it
+    */
+  template <typename T, int W>
+  inline Eigen::Array<bool, W, 1> intersectBox(const RayPacket<T, W>& rays, const Eigen::Matrix<T, 3, 1>& center, const Eigen::Matrix<T, 3, 3>& axes,
+                                               const Eigen::Matrix<T, 3, 1>& half_sizes, Eigen::Array<T, W, 1>& t);
+
+  /**
+    * Capped cylinder, given the center of its base, its axis (from base to top), radius and height
+    */
+  template <typename T, int W>
+  inline Eigen::Array<bool, W, 1> intersectCylinder(const RayPacket<T, W>& rays, const Eigen::Matrix<T, 3, 1>& base_center, const Eigen::Matrix<T, 3, 1>& axis,
+                                                    T radius, T height, Eigen::Array<T, W, 1>& t);
+
+  /**
+    * Capped cone, given the center of its base, its axis (from base to tip), radius and height
+    */
+  template <typename T, int W>
+  inline Eigen::Array<bool, W, 1> intersectCone(const RayPacket<T, W>& rays, const Eigen::Matrix<T, 3, 1>& base_center, const Eigen::Matrix<T, 3, 1>& axis,
+                                                T radius, T height, Eigen::Array<T, W, 1>& t);
+
+  /**
+    * Triangle (Moller-Trumbore), both faces
+    */
+  template <typename T, int W>
+  inline Eigen::Array<bool, W, 1> intersectTriangle(const RayPacket<T, W>& rays, const Eigen::Matrix<T, 3, 1>& v0, const Eigen::Matrix<T, 3, 1>& v1,
+                                                    const Eigen::Matrix<T, 3, 1>& v2, Eigen::Array<T, W, 1>& t);
+
+  /**
+    * Closest triangle of a mesh (used for shapes whose parameters do not describe them anymore, e.g. after scale3D)
+    */
+  template <typename T, typename INDEX, int W>
+  inline Eigen::Array<bool, W, 1> intersectMesh(const RayPacket<T, W>& rays, const Mesh<T, INDEX>& mesh, Eigen::Array<T, W, 1>& t);
+
+  /**
+    * Single ray version of the packet "intersect" of a shape
+    */
+  template <typename T, typename SHAPE>
+  inline bool intersectSingle(const SHAPE& shape, const Ray<T>& ray, T& t);
+
+  /**
+    * Keeps in "t" the candidate distances which are valid, within [t_min, t_max] and closer than the current ones, and adds them to the hit mask
+    */
+  template <typename T, int W>
+  inline void keepClosest(const RayPacket<T, W>& rays, const typename RayPacket<T, W>::Lanes& candidate, const typename RayPacket<T, W>::Mask& valid,
+                          Eigen::Array<T, W, 1>& t, Eigen::Array<bool, W, 1>& hit);
+
+  /**
+    * Cross product of W vectors (one per row) with a vector
+    */
+  template <typename T, int W>
+  inline Eigen::Array<T, W, 3> cross(const Eigen::Array<T, W, 3>& a, const Eigen::Matrix<T, 3, 1>& b);
+
+
+
+
+
+  template <typename T, int W>
+  inline Eigen::Array<bool, W, 1> intersectDisk(const RayPacket<T, W>& rays, const Eigen::Matrix<T, 3, 1>& center, const Eigen::Matrix<T, 3, 1>& normal, T radius,
+                                                Eigen::Array<T, W, 1>& t){
+    // Rays parallel to the plane get infinite or NaN distances, which fail the comparisons
+    t = (center.dot(normal) - (rays.origin.matrix() * normal).array()) / (rays.direction.matrix() * normal).array();
+    Eigen::Array<T, W, 1> distance2 = ((rays.origin + rays.direction.colwise() * t).rowwise() - center.transpose().array()).rowwise().squaredNorm();
+
+    return (t >= rays.t_min) && (t <= rays.t_max) && (distance2 <= radius * radius);
+  }
+
+
+  template <typename T, int W>
+  inline Eigen::Array<bool, W, 1> intersectRectangle(const RayPacket<T, W>& rays, const Eigen::Matrix<T, 3, 1>& center,
+                                                     const Eigen::Matrix<T, 3, 1>& axis_u, const Eigen::Matrix<T, 3, 1>& axis_v, T half_u, T half_v,
+                                                     Eigen::Array<T, W, 1>& t){
+    Eigen::Matrix<T, 3, 1> normal = axis_u.cross(axis_v);
+    t = (center.dot(normal) - (rays.origin.matrix() * normal).array()) / (rays.direction.matrix() * normal).array();
+    Eigen::Array<T, W, 3> local = (rays.origin + rays.direction.colwise() * t).rowwise() - center.transpose().array();
+
+    return (t >= rays.t_min) && (t <= rays.t_max) && ((local.matrix() * axis_u).array().abs() <= half_u) && ((local.matrix() * axis_v).array().abs() <= half_v);
+  }
+
+
+  template <typename T, int W>
+  inline Eigen::Array<bool, W, 1> intersectBox(const RayPacket<T, W>& rays, const Eigen::Matrix<T, 3, 1>& center, const Eigen::Matrix<T, 3, 3>& axes,
+                                               const Eigen::Matrix<T, 3, 1>& half_sizes, Eigen::Array<T, W, 1>& t){
+    // Slab test in the frame of the box
+    Eigen::Array<T, W, 3> origin = ((rays.origin.rowwise() - center.transpose().array()).matrix() * axes).array();
+    Eigen::Array<T, W, 3> inverse_direction = (rays.direction.matrix() * axes).array().inverse();
+
+    Eigen::Array<T, W, 3> t1 = (-origin).rowwise() - half_sizes.transpose().array();
+    Eigen::Array<T, W, 3> t2 = (-origin).rowwise() + half_sizes.transpose().array();
+    t1 *= inverse_direction;
+    t2 *= inverse_direction;
+
+    Eigen::Array<T, W, 1> t_near = t1.min(t2).rowwise().maxCoeff();
+    Eigen::Array<T, W, 1> t_far = t1.max(t2).rowwise().minCoeff();
+
+    Eigen::Array<bool, W, 1> hit {Eigen::Array<bool, W, 1>::Constant(false)};
+    t.setConstant(std::numeric_limits<T>::infinity());
+    Eigen::Array<bool, W, 1> crossed = t_near <= t_far;
+    keepClosest(rays, t_near, crossed, t, hit);
+    keepClosest(rays, t_far, crossed, t, hit);
+
+    return hit;
+  }
+
+
+  template <typename T, int W>
+  inline Eigen::Array<bool, W, 1> intersectCylinder(const RayPacket<T, W>& rays, const Eigen::Matrix<T, 3, 1>& base_center, const Eigen::Matrix<T, 3, 1>& axis,
+                                                    T radius, T height, Eigen::Array<T, W, 1>& t){
+    Eigen::Array<T, W, 3> origin = rays.origin.rowwise() - base_center.transpose().array();
+    Eigen::Array<T, W, 1> origin_axial = (origin.matrix() * axis).array();
+    Eigen::Array<T, W, 1> direction_axial = (rays.direction.matrix() * axis).array();
+
+    // Components perpendicular to the axis
+    Eigen::Array<T, W, 3> origin_radial = origin - (origin_axial.matrix() * axis.transpose()).array();
+    Eigen::Array<T, W, 3> direction_radial = rays.direction - (direction_axial.matrix() * axis.transpose()).array();
+
+    Eigen::Array<bool, W, 1> hit {Eigen::Array<bool, W, 1>::Constant(false)};
+    t.setConstant(std::numeric_limits<T>::infinity());
+
+    // Side: |origin_radial + t * direction_radial| = radius
+    Eigen::Array<T, W, 1> a = direction_radial.rowwise().squaredNorm();
+    Eigen::Array<T, W, 1> b = (origin_radial * direction_radial).rowwise().sum();
+    Eigen::Array<T, W, 1> c = origin_radial.rowwise().squaredNorm() - radius * radius;
+    Eigen::Array<T, W, 1> discriminant = b * b - a * c;
+    Eigen::Array<T, W, 1> root = discriminant.max(static_cast<T>(0)).sqrt();
+    for(T sign : {static_cast<T>(-1), static_cast<T>(1)}){
+      Eigen::Array<T, W, 1> candidate = (-b + sign * root) / a;
+      Eigen::Array<T, W, 1> axial = origin_axial + candidate * direction_axial;
+      keepClosest(rays, candidate, (discriminant >= 0) && (axial >= 0) && (axial <= height), t, hit);
+    }
+
+    // Caps
+    for(T cap : {static_cast<T>(0), height}){
+      Eigen::Array<T, W, 1> candidate = (cap - origin_axial) / direction_axial;
+      Eigen::Array<T, W, 1> distance2 = (origin_radial + direction_radial.colwise() * candidate).rowwise().squaredNorm();
+      keepClosest(rays, candidate, distance2 <= radius * radius, t, hit);
+    }
+
+    return hit;
+  }
+
+
+  template <typename T, int W>
+  inline Eigen::Array<bool, W, 1> intersectCone(const RayPacket<T, W>& rays, const Eigen::Matrix<T, 3, 1>& base_center, const Eigen::Matrix<T, 3, 1>& axis,
+                                                T radius, T height, Eigen::Array<T, W, 1>& t){
+    // Relative to the tip, the side is |q|^2 = (1 + k^2) (q.axis)^2 with q.axis in [-height, 0], k = radius / height
+    Eigen::Matrix<T, 3, 1> tip = base_center + height * axis;
+    T m = static_cast<T>(1) + radius * radius / (height * height);
+
+    Eigen::Array<T, W, 3> origin = rays.origin.rowwise() - tip.transpose().array();
+    Eigen::Array<T, W, 1> origin_axial = (origin.matrix() * axis).array();
+    Eigen::Array<T, W, 1> direction_axial = (rays.direction.matrix() * axis).array();
+
+    Eigen::Array<bool, W, 1> hit {Eigen::Array<bool, W, 1>::Constant(false)};
+    t.setConstant(std::numeric_limits<T>::infinity());
+
+    // Side
+    Eigen::Array<T, W, 1> a = rays.direction.rowwise().squaredNorm() - m * direction_axial * direction_axial;
+    Eigen::Array<T, W, 1> b = (origin * rays.direction).rowwise().sum() - m * origin_axial * direction_axial;
+    Eigen::Array<T, W, 1> c = origin.rowwise().squaredNorm() - m * origin_axial * origin_axial;
+    Eigen::Array<T, W, 1> discriminant = b * b - a * c;
+    Eigen::Array<T, W, 1> root = discriminant.max(static_cast<T>(0)).sqrt();
+    for(T sign : {static_cast<T>(-1), static_cast<T>(1)}){
+      Eigen::Array<T, W, 1> candidate = (-b + sign * root) / a;
+      Eigen::Array<T, W, 1> axial = origin_axial + candidate * direction_axial;
+      keepClosest(rays, candidate, (discriminant >= 0) && (axial >= -height) && (axial <= 0), t, hit);
+    }
+
+    // Base
+    Eigen::Array<T, W, 1> candidate = (-height - origin_axial) / direction_axial;
+    Eigen::Array<T, W, 1> distance2 = ((origin + rays.direction.colwise() * candidate).rowwise() + (height * axis).transpose().array()).rowwise().squaredNorm();
+    keepClosest(rays, candidate, distance2 <= radius * radius, t, hit);
+
+    return hit;
+  }
+
+
+  template <typename T, int W>
+  inline Eigen::Array<bool, W, 1> intersectTriangle(const RayPacket<T, W>& rays, const Eigen::Matrix<T, 3, 1>& v0, const Eigen::Matrix<T, 3, 1>& v1,
+                                                    const Eigen::Matrix<T, 3, 1>& v2, Eigen::Array<T, W, 1>& t){
+    Eigen::Matrix<T, 3, 1> edge1 = v1 - v0;
+    Eigen::Matrix<T, 3, 1> edge2 = v2 - v0;
+
+    Eigen::Array<T, W, 3> p = cross(rays.direction, edge2);
+    Eigen::Array<T, W, 1> determinant = (p.matrix() * edge1).array();
+    Eigen::Array<T, W, 1> inverse = determinant.inverse();
+
+    Eigen::Array<T, W, 3> s = rays.origin.rowwise() - v0.transpose().array();
+    Eigen::Array<T, W, 1> u = (s * p).rowwise().sum() * inverse;
+
+    Eigen::Array<T, W, 3> q = cross(s, edge1);
+    Eigen::Array<T, W, 1> v = (rays.direction * q).rowwise().sum() * inverse;
+    t = (q.matrix() * edge2).array() * inverse;
+
+    return (determinant != 0) && (u >= 0) && (v >= 0) && (u + v <= 1) && (t >= rays.t_min) && (t <= rays.t_max);
+  }
+
+
+  template <typename T, typename INDEX, int W>
+  inline Eigen::Array<bool, W, 1> intersectMesh(const RayPacket<T, W>& rays, const Mesh<T, INDEX>& mesh, Eigen::Array<T, W, 1>& t){
+    Eigen::Array<bool, W, 1> hit {Eigen::Array<bool, W, 1>::Constant(false)};
+    t.setConstant(std::numeric_limits<T>::infinity());
+
+    Eigen::Array<T, W, 1> candidate;
+    for(size_t i = 0; i < mesh.indices.size(); i += 3){
+      Eigen::Matrix<T, 3, 1> v[3];
+      for(uint8_t j = 0; j < 3; j++)
+        v[j] = Eigen::Map<const Eigen::Matrix<T, 3, 1>>(mesh.vertices.data() + mesh.indices[i + j] * Mesh<T, INDEX>::VERTEX_SIZE);
+
+      Eigen::Array<bool, W, 1> valid = intersectTriangle(rays, v[0], v[1], v[2], candidate);
+      keepClosest(rays, candidate, valid, t, hit);
+    }
+
+    return hit;
+  }
+
+
+  template <typename T, typename SHAPE>
+  inline bool intersectSingle(const SHAPE& shape, const Ray<T>& ray, T& t){
+    RayPacket<T, 1> packet(&ray);
+    Eigen::Array<T, 1, 1> distance;
+    bool hit = shape.intersect(packet, distance)[0];
+    t = distance[0];
+
+    return hit;
+  }
+
+
+  template <typename T, int W>
+  inline void keepClosest(const RayPacket<T, W>& rays, const typename RayPacket<T, W>::Lanes& candidate, const typename RayPacket<T, W>::Mask& valid,
+                          Eigen::Array<T, W, 1>& t, Eigen::Array<bool, W, 1>& hit){
+    Eigen::Array<bool, W, 1> closer = valid && (candidate >= rays.t_min) && (candidate <= rays.t_max) && (candidate < t);
+    t = closer.select(candidate, t);
+    hit = hit || closer;
+  }
+
+
+  template <typename T, int W>
+  inline Eigen::Array<T, W, 3> cross(const Eigen::Array<T, W, 3>& a, const Eigen::Matrix<T, 3, 1>& b){
+    Eigen::Array<T, W, 3> c;
+    c.col(0) = a.col(1) * b.z() - a.col(2) * b.y();
+    c.col(1) = a.col(2) * b.x() - a.col(0) * b.z();
+    c.col(2) = a.col(0) * b.y() - a.col(1) * b.x();
+
+    return c;
+  }
+
+} // namespace geo
+
+
+#endif // INTERSECTION_H
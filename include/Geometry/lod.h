@@ -0,0 +1,167 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <initializer_list>
+
+#include <Eigen/Geometry>
+
+#include "constants.h"
+#include "tessellation_cache.h"
+
+namespace geo {
+
+  /**
+    * Maximum distance between a circle of the given radius and its polygon of n vertices (sagitta of the chords)
+    */
+  template <typename T>
+  inline T chordError(T radius, size_t num_vertices);
+
+  /**
+    * Minimum number of vertices of the polygon of a circle of the given radius for a maximum error (at least 3)
+    */
+  template <typename T>
+  inline size_t verticesForError(T radius, T max_error);
+
+
+  /** STRUCT LODView
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * Converts errors in world units into pixels, for a view (e.g. CartesianCS_3D::transformMatrix) and a projection (perspectiveProjection or
+    * orthoProjection) rendered to a viewport "viewport_height" pixels high
+    */
+
+  template <typename T = float>
+  struct LODView {
+    Eigen::Matrix<T, 4, 4> view;
+    // Pixels per world unit at distance 1 (perspective) or at any distance (orthographic)
+    T pixels_per_unit;
+    bool perspective;
+
+    LODView(const Eigen::Matrix<T, 4, 4>& view, const Eigen::Matrix<T, 4, 4>& projection, T viewport_height) :
+        view{view}, pixels_per_unit{projection(1, 1) * viewport_height / static_cast<T>(2)}, perspective{projection(3, 3) == 0} {}
+
+    /**
+      * Size in pixels of an error in world units, at the point of a sphere (center in world coordinates) closest to the viewer.
+      * Infinite if the sphere contains the viewer
+      */
+    T pixels(T error, const Eigen::Matrix<T, 3, 1>& center, T radius) const {
+      if (!perspective) return error * pixels_per_unit;
+
+      // The view looks along -Z
+      T depth = -(view.template topRows<3>() * center.homogeneous()).z() - radius;
+      if (depth <= 0) return std::numeric_limits<T>::infinity();
+
+      return error * pixels_per_unit / depth;
+    }
+  };
+
+
+  /** CLASS LODChain
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * Tessellations of one round primitive (Circle, Cylinder, Cone) with increasing numbers of vertices, built once, with their chord errors.
+    * select() picks the coarsest level whose error, projected on the screen, is within a budget of pixels. Switching levels only hands out
+    * another shared tessellation: there is no allocation.
+    * Parameters:
+    *            - levels: numbers of vertices of the round parts (default = 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256)
+    */
+
+  template <typename T = float>
+  class LODChain {
+    // Largest radius of the round parts (for the chord errors)
+    T _radius;
+    // Radius of a sphere centered at the local origin of the tessellations which contains all of them (for the projection of the errors)
+    T _bounding_radius {0};
+    std::vector<size_t> _num_vertices;
+    std::vector<T> _errors;
+    std::vector<std::shared_ptr<const Tessellation<T>>> _tessellations;
+
+    LODChain() {}
+
+  public:
+    /**
+      * Builds SHAPE(args..., n) for every level n (through the tessellation cache). "radius" is the largest radius of the round parts
+      */
+    template <typename SHAPE, typename... ARGS>
+    static LODChain create(std::initializer_list<size_t> levels, T radius, const ARGS&... args) {
+      LODChain chain;
+      chain._radius = radius;
+      chain._num_vertices.assign(levels.begin(), levels.end());
+      std::sort(chain._num_vertices.begin(), chain._num_vertices.end());
+      if (chain._num_vertices.empty() || chain._num_vertices.front() < 3)
+        throw std::invalid_argument("LOD levels need at least 3 vertices.");
+
+      for(size_t n : chain._num_vertices){
+        chain._errors.push_back(chordError(radius, n));
+        chain._tessellations.push_back(TessellationCache<T>::global().template get<SHAPE>(args..., n));
+
+        const BoundingSphere<T, 3>& sphere = chain._tessellations.back()->sphere;
+        chain._bounding_radius = std::max(chain._bounding_radius, sphere.center.norm() + sphere.radius);
+      }
+
+      return chain;
+    }
+
+    template <typename SHAPE, typename... ARGS>
+    static LODChain create(T radius, const ARGS&... args) {
+      return create<SHAPE>({8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256}, radius, args...);
+    }
+
+    size_t size() const { return _num_vertices.size(); }
+
+    T radius() const { return _radius; }
+
+    T boundingRadius() const { return _bounding_radius; }
+
+    size_t numVertices(size_t level) const { return _num_vertices.at(level); }
+
+    T error(size_t level) const { return _errors.at(level); }
+
+    const Tessellation<T> & tessellation(size_t level) const { return *_tessellations.at(level); }
+
+    const std::shared_ptr<const Tessellation<T>> & shared(size_t level) const { return _tessellations.at(level); }
+
+    /**
+      * Coarsest level with a projected error of at most "max_pixels", for the primitive with the local origin of its tessellation at "center"
+      *   (world coordinates), or the finest one if none meets the budget. The error is projected at the point closest to the viewer of the sphere
+      *   of radius boundingRadius() around "center"
+      */
+    size_t select(const LODView<T>& view, const Eigen::Matrix<T, 3, 1>& center, T max_pixels) const {
+      for(size_t level = 0; level < _errors.size(); level++)
+        if (view.pixels(_errors[level], center, _bounding_radius) <= max_pixels)
+          return level;
+
+      return _errors.size() - 1;
+    }
+  }; // class LODChain
+
+
+
+
+
+  template <typename T>
+  inline T chordError(T radius, size_t num_vertices){
+    return radius * (static_cast<T>(1) - std::cos(static_cast<T>(_PI_) / num_vertices));
+  }
+
+
+  template <typename T>
+  inline size_t verticesForError(T radius, T max_error){
+    if (max_error >= radius) return 3;
+
+    T n = static_cast<T>(_PI_) / std::acos(static_cast<T>(1) - max_error / radius);
+    return std::max<size_t>(3, static_cast<size_t>(std::ceil(n)));
+  }
+
+} // namespace geo
+
+
+#endif // LOD_H
@@ -0,0 +1,139 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <vector>
+#include <limits>
+#include <stdexcept>
+
+#include "point.h"
+
+namespace geo {
+
+  /** STRUCT MeshSize
+    * Number of vertices and indices of the triangle mesh of a shape (to size the buffers passed to toMesh)
+    */
+
+  struct MeshSize {
+    size_t vertices;
+    size_t indices;
+  };
+
+
+  /** STRUCT Mesh
+    * Template params:
+    *                 T --> type used for the coordinates
+    *                 INDEX --> type of the indices (uint16_t or uint32_t)
+    *
+    * GPU-ready triangle mesh:
+    *            - vertices: interleaved vertex buffer, VERTEX_SIZE values per vertex (position x, y, z followed by normal x, y, z)
+    *            - indices: 3 indices per triangle, anticlockwise when seen from the outside of the shape
+    */
+
+  template <typename T = float, typename INDEX = uint32_t>
+  struct Mesh {
+    static constexpr size_t VERTEX_SIZE {6};
+
+    std::vector<T> vertices;
+    std::vector<INDEX> indices;
+
+    size_t size() const { return vertices.size() / VERTEX_SIZE; }
+  };
+
+
+  /** CLASS MeshWriter
+    * Template params:
+    *                 T --> type used for the coordinates
+    *                 INDEX --> type of the indices
+    *
+    * Writes the vertices and triangles of a mesh into caller-provided buffers (with the layout of Mesh), which must be big enough
+    */
+
+  template <typename T, typename INDEX>
+  class MeshWriter {
+    T* _vertex_buffer;
+    INDEX* _index_buffer;
+    INDEX _num_vertices {0};
+
+  public:
+    MeshWriter(const MeshSize& size, T* vertex_buffer, INDEX* index_buffer) : _vertex_buffer{vertex_buffer}, _index_buffer{index_buffer} {
+      if (size.vertices > static_cast<size_t>(std::numeric_limits<INDEX>::max()) + 1)
+        throw std::invalid_argument("Too many vertices for the index type.");
+    }
+
+    /**
+      * Adds a vertex and returns its index
+      */
+    INDEX vertex(const Eigen::Matrix<T, 3, 1>& position, const Eigen::Matrix<T, 3, 1>& normal) {
+      for(uint8_t i = 0; i < 3; i++){
+        _vertex_buffer[i] = position[i];
+        _vertex_buffer[i + 3] = normal[i];
+      }
+      _vertex_buffer += Mesh<T, INDEX>::VERTEX_SIZE;
+
+      return _num_vertices++;
+    }
+
+    void triangle(INDEX v1, INDEX v2, INDEX v3) {
+      _index_buffer[0] = v1;
+      _index_buffer[1] = v2;
+      _index_buffer[2] = v3;
+      _index_buffer += 3;
+    }
+
+    /**
+      * Flat polygon triangulated as a fan around its centroid: n + 1 vertices and n triangles.
+      * The triangles are anticlockwise seen from the side the normal points to if the ring is anticlockwise (reversed = false)
+      */
+    void fan(const Point<T, 3>* ring, size_t n, const Eigen::Matrix<T, 3, 1>& normal, bool reversed) {
+      INDEX center = vertex(centroid(ring, n), normal);
+      for(size_t i = 0; i < n; i++)
+        vertex(ring[i], normal);
+
+      for(size_t i = 0; i < n; i++){
+        INDEX current = center + 1 + i;
+        INDEX next = center + 1 + (i + 1) % n;
+        if (reversed)
+          triangle(center, next, current);
+        else
+          triangle(center, current, next);
+      }
+    }
+
+    static Eigen::Matrix<T, 3, 1> centroid(const Point<T, 3>* points, size_t n) {
+      Eigen::Matrix<T, 3, 1> sum {Eigen::Matrix<T, 3, 1>::Zero()};
+      for(size_t i = 0; i < n; i++)
+        sum += points[i];
+      return sum / static_cast<T>(n);
+    }
+
+    /**
+      * Normal of a flat polygon (Newell's method), pointing to the side from which the polygon is seen anticlockwise
+      */
+    static Eigen::Matrix<T, 3, 1> polygonNormal(const Point<T, 3>* points, size_t n) {
+      Eigen::Matrix<T, 3, 1> normal {Eigen::Matrix<T, 3, 1>::Zero()};
+      for(size_t i = 0; i < n; i++)
+        normal += points[i].cross(points[(i + 1) % n]);
+      return normal.normalized();
+    }
+  }; // class MeshWriter
+
+
+  /**
+    * Builds the mesh of a shape in newly allocated buffers (shapes provide meshSize() and toMesh(vertex_buffer, index_buffer))
+    */
+  template <typename T, typename INDEX, typename SHAPE>
+  inline Mesh<T, INDEX> makeMesh(const SHAPE& shape) {
+    MeshSize size = shape.meshSize();
+
+    Mesh<T, INDEX> mesh;
+    mesh.vertices.resize(size.vertices * Mesh<T, INDEX>::VERTEX_SIZE);
+    mesh.indices.resize(size.indices);
+    shape.toMesh(mesh.vertices.data(), mesh.indices.data());
+
+    return mesh;
+  }
+
+} // namespace geo
+
+
+#endif // MESH_H
@@ -0,0 +1,130 @@
+#ifndef PADDED_SHAPE_H
+#define PADDED_SHAPE_H
+
+#include <vector>
+
+#include "shape.h"
+#include "transformations.h"
+#include "executor.h"
+
+namespace geo {
+
+  /** CLASS PaddedShape
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * Vertices and normals of a 3D shape stored with 4 components (x, y, z, w), each one aligned to its own size: w = 1 for the vertices
+    * and w = 0 for the normals.
+    * Transformations are then one aligned 4x4 matrix-vector product per vertex (translation included), without unaligned loads of 12-byte points.
+    * With floats, data() and normalsData() follow the layout of a vec4 array in std140 / std430 buffers, so they can be uploaded to the GPU
+    * without repacking.
+    */
+
+  template <typename T = float>
+  class PaddedShape {
+  public:
+    typedef Eigen::Matrix<T, 4, 1> Vector;
+
+  private:
+    std::vector<Vector, Eigen::aligned_allocator<Vector>> _vertices;
+    std::vector<Vector, Eigen::aligned_allocator<Vector>> _normals;
+
+    static void transformVertices(const Eigen::Matrix<T, 4, 4>& matrix, Vector* first, Vector* last) {
+      while(first != last){
+        *first = matrix * (*first);
+        first++;
+      }
+    }
+
+    // Inverse-transpose of the linear part, with zeros in the rest (w = 0 is preserved, so the normalization only involves x, y and z)
+    static Eigen::Matrix<T, 4, 4> normalMatrix(const Eigen::Transform<T, 3, Eigen::Affine>& matrix) {
+      Eigen::Matrix<T, 4, 4> normal_matrix {Eigen::Matrix<T, 4, 4>::Zero()};
+      normal_matrix.template topLeftCorner<3, 3>() = matrix.linear().inverse().transpose();
+      return normal_matrix;
+    }
+
+  public:
+    PaddedShape() {}
+
+    PaddedShape(const Shape<T, 3>& shape) {
+      _vertices.reserve(shape.vertices().size());
+      for(const Point<T, 3>& v : shape.vertices())
+        _vertices.emplace_back(v.x(), v.y(), v.z(), static_cast<T>(1));
+
+      _normals.reserve(shape.normals().size());
+      for(const Eigen::Matrix<T, 3, 1>& n : shape.normals())
+        _normals.emplace_back(n.x(), n.y(), n.z(), static_cast<T>(0));
+    }
+
+    ~PaddedShape() {}
+
+    size_t size() const { return _vertices.size(); }
+
+    const std::vector<Vector, Eigen::aligned_allocator<Vector>> & vertices() const { return _vertices; }
+    const std::vector<Vector, Eigen::aligned_allocator<Vector>> & normals() const { return _normals; }
+
+    Point<T, 3> vertex(size_t pos) const {
+      const Vector& v = _vertices.at(pos);
+      return Point<T, 3>(v.x(), v.y(), v.z());
+    }
+
+    Eigen::Matrix<T, 3, 1> normal(size_t pos) const { return _normals.at(pos).template head<3>(); }
+
+    // 4 coordinates per vertex / normal
+    const T* data() const { return _vertices.data()->data(); }
+    const T* normalsData() const { return _normals.data()->data(); }
+
+    /**
+      * Affine transformation: vertices are transformed with the matrix and normals with its inverse-transpose (and renormalized)
+      */
+    void transform(const Eigen::Transform<T, 3, Eigen::Affine>& matrix) {
+      GEO_SCOPED_TIMER(TRANSFORM_PASS);
+      GEO_COUNT(VERTICES_PROCESSED, _vertices.size());
+
+      transformVertices(matrix.matrix(), _vertices.data(), _vertices.data() + _vertices.size());
+      transformNormals(normalMatrix(matrix), _normals.data(), _normals.data() + _normals.size());
+    }
+
+    /**
+      * Same as above, with the vertices and normals split across the threads of the executor
+      */
+    void transform(const Eigen::Transform<T, 3, Eigen::Affine>& matrix, const Executor& executor) {
+      GEO_SCOPED_TIMER(TRANSFORM_PASS);
+      GEO_COUNT(VERTICES_PROCESSED, _vertices.size());
+
+      const Eigen::Matrix<T, 4, 4> vertex_matrix {matrix.matrix()};
+      Vector* vertices = _vertices.data();
+      executor.parallelFor(_vertices.size(), [&](size_t first, size_t last){ transformVertices(vertex_matrix, vertices + first, vertices + last); });
+
+      transformNormals(executor, normalMatrix(matrix), _normals.data(), _normals.data() + _normals.size());
+    }
+
+    void scale3D(T scale){
+      scale3D(scale, scale, scale);
+    }
+
+    void scale3D(T scale_X, T scale_Y, T scale_Z){
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::Scaling(scale_X, scale_Y, scale_Z)));
+    }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis) {
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::AngleAxis<T>(angle, axis)));
+    }
+
+    void scale3D(T scale, const Executor& executor){
+      scale3D(scale, scale, scale, executor);
+    }
+
+    void scale3D(T scale_X, T scale_Y, T scale_Z, const Executor& executor){
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::Scaling(scale_X, scale_Y, scale_Z)), executor);
+    }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis, const Executor& executor) {
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::AngleAxis<T>(angle, axis)), executor);
+    }
+  }; // class PaddedShape
+
+} // namespace geo
+
+
+#endif // PADDED_SHAPE_H
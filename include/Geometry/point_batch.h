@@ -0,0 +1,204 @@
+#ifndef POINT_BATCH_H
+#define POINT_BATCH_H
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+#include <Eigen/Geometry>
+
+#include "point.h"
+
+namespace geo {
+
+  /** STRUCT PointBatch
+    * Template params:
+    *                 T --> type used for the coordinates
+    *                 DIM --> Number of dimensions
+    *                 W --> number of points (lanes): 4, 8 or 16 fill one SSE, AVX or AVX-512 register of floats
+    *
+    * W points stored as structure of arrays (same layout as RayPacket): each coordinate is one column of W contiguous lanes, so arithmetic,
+    * dot and cross products, norms and distances run on the W points with SIMD instructions.
+    */
+
+  template <typename T = float, uint8_t DIM = 3, int W = 8>
+  struct PointBatch {
+    typedef Eigen::Array<T, W, 1> Lanes;
+    typedef Eigen::Array<T, W, DIM> Coordinates;
+
+    Coordinates coords;
+
+    PointBatch() : coords{Coordinates::Zero()} {}
+
+    explicit PointBatch(const Coordinates& coords) : coords{coords} {}
+
+    /**
+      * Same point in all the lanes
+      */
+    explicit PointBatch(const Eigen::Matrix<T, DIM, 1>& point) : coords{point.transpose().array().template replicate<W, 1>()} {}
+
+    /**
+      * Loads "count" (up to W) consecutive points. The remaining lanes are zero
+      */
+    PointBatch(const Point<T, DIM>* points, size_t count = W) {
+      if (count == W)
+        // Each coordinate is a strided column of the interleaved points
+        for(int c = 0; c < DIM; c++)
+          coords.col(c) = Eigen::Map<const Lanes, Eigen::Unaligned, Eigen::InnerStride<DIM>>(points->data() + c);
+      else{
+        coords.setZero();
+        coords.topRows(count) = Eigen::Map<const Eigen::Matrix<T, DIM, Eigen::Dynamic>>(points->data(), DIM, count).transpose().array();
+      }
+    }
+
+    /**
+      * Writes the first "count" (up to W) points
+      */
+    void store(Point<T, DIM>* points, size_t count = W) const {
+      Eigen::Map<Eigen::Matrix<T, DIM, Eigen::Dynamic>>(points->data(), DIM, count) = coords.topRows(count).transpose().matrix();
+    }
+
+    void set(int lane, const Eigen::Matrix<T, DIM, 1>& point) { coords.row(lane) = point.transpose().array(); }
+
+    Point<T, DIM> operator[](int lane) const {
+      Point<T, DIM> point;
+      point = coords.row(lane).transpose().matrix();
+      return point;
+    }
+
+    PointBatch operator+(const PointBatch& b) const { return PointBatch(Coordinates(coords + b.coords)); }
+    PointBatch operator-(const PointBatch& b) const { return PointBatch(Coordinates(coords - b.coords)); }
+    PointBatch operator*(T scale) const { return PointBatch(Coordinates(coords * scale)); }
+
+    // One scale per lane
+    PointBatch operator*(const Lanes& scale) const { return PointBatch(Coordinates(coords.colwise() * scale)); }
+
+    Lanes dot(const PointBatch& b) const { return (coords * b.coords).rowwise().sum(); }
+
+    Lanes squaredNorm() const { return coords.square().rowwise().sum(); }
+    Lanes norm() const { return squaredNorm().sqrt(); }
+
+    PointBatch normalized() const { return PointBatch(Coordinates(coords.colwise() / norm())); }
+
+    PointBatch cross(const PointBatch& b) const {
+      static_assert(DIM == 3, "Cross product is only defined in 3 dimensions");
+
+      Coordinates c;
+      c.col(0) = coords.col(1) * b.coords.col(2) - coords.col(2) * b.coords.col(1);
+      c.col(1) = coords.col(2) * b.coords.col(0) - coords.col(0) * b.coords.col(2);
+      c.col(2) = coords.col(0) * b.coords.col(1) - coords.col(1) * b.coords.col(0);
+      return PointBatch(c);
+    }
+
+    Lanes squaredDistance(const PointBatch& b) const { return (coords - b.coords).square().rowwise().sum(); }
+    Lanes distance(const PointBatch& b) const { return squaredDistance(b).sqrt(); }
+  }; // struct PointBatch
+
+
+  /**
+    * Packs "count" points into batches of W (the last one padded with zeros)
+    */
+  template <int W = 8, typename T, uint8_t DIM>
+  inline void toBatches(const Point<T, DIM>* points, size_t count, std::vector<PointBatch<T, DIM, W>>& batches);
+
+  /**
+    * Squared distances from "count" points to "query", W points at a time.
+    * Points already packed in batches avoid the transposition from the interleaved layout (worth it for repeated queries)
+    */
+  template <int W, typename T, uint8_t DIM>
+  inline void squaredDistances(const PointBatch<T, DIM, W>* batches, size_t count, const Eigen::Matrix<T, int(DIM), 1>& query, T* distances);
+
+  template <int W = 8, typename T, uint8_t DIM>
+  inline void squaredDistances(const Point<T, DIM>* points, size_t count, const Eigen::Matrix<T, int(DIM), 1>& query, T* distances);
+
+  /**
+    * Index of the point closest to "query" (count if there are no points), W points at a time
+    */
+  template <int W, typename T, uint8_t DIM>
+  inline size_t nearest(const PointBatch<T, DIM, W>* batches, size_t count, const Eigen::Matrix<T, int(DIM), 1>& query);
+
+  template <int W = 8, typename T, uint8_t DIM>
+  inline size_t nearest(const Point<T, DIM>* points, size_t count, const Eigen::Matrix<T, int(DIM), 1>& query);
+
+
+
+
+
+  // Nearest point of the batches returned by load(i) for i = 0, W, 2 * W... (lanes past count are ignored)
+  template <int W, typename LOAD, typename T, int DIM>
+  inline size_t nearestBatch(LOAD load, size_t count, const Eigen::Matrix<T, DIM, 1>& query){
+    typedef typename PointBatch<T, DIM, W>::Lanes Lanes;
+    typedef Eigen::Array<Eigen::Index, W, 1> Indices;
+
+    const PointBatch<T, DIM, W> q(query);
+    const Indices lanes {Indices::LinSpaced(W, 0, W - 1)};
+
+    // Closest point seen by each lane
+    Lanes best {Lanes::Constant(std::numeric_limits<T>::infinity())};
+    Indices best_index {Indices::Constant(static_cast<Eigen::Index>(count))};
+
+    for(size_t i = 0; i < count; i += W){
+      Lanes d = load(i).squaredDistance(q);
+      if (count - i < W) d.tail(W - (count - i)).setConstant(std::numeric_limits<T>::infinity());
+
+      Eigen::Array<bool, W, 1> closer = d < best;
+      best = closer.select(d, best);
+      best_index = closer.select(lanes + static_cast<Eigen::Index>(i), best_index);
+    }
+
+    Eigen::Index lane;
+    best.minCoeff(&lane);
+    return best_index[lane];
+  }
+
+
+  template <int W, typename T, uint8_t DIM>
+  inline void toBatches(const Point<T, DIM>* points, size_t count, std::vector<PointBatch<T, DIM, W>>& batches){
+    batches.clear();
+    batches.reserve((count + W - 1) / W);
+    for(size_t i = 0; i < count; i += W)
+      batches.emplace_back(points + i, std::min<size_t>(W, count - i));
+  }
+
+
+  template <int W, typename T, uint8_t DIM>
+  inline void squaredDistances(const PointBatch<T, DIM, W>* batches, size_t count, const Eigen::Matrix<T, int(DIM), 1>& query, T* distances){
+    const PointBatch<T, DIM, W> q(query);
+
+    size_t i {0};
+    for(; i + W <= count; i += W)
+      Eigen::Map<Eigen::Array<T, W, 1>>(distances + i) = (batches++)->squaredDistance(q);
+
+    if (i < count)
+      Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>(distances + i, count - i) = batches->squaredDistance(q).head(count - i);
+  }
+
+
+  template <int W, typename T, uint8_t DIM>
+  inline void squaredDistances(const Point<T, DIM>* points, size_t count, const Eigen::Matrix<T, int(DIM), 1>& query, T* distances){
+    const PointBatch<T, DIM, W> q(query);
+
+    size_t i {0};
+    for(; i + W <= count; i += W)
+      Eigen::Map<Eigen::Array<T, W, 1>>(distances + i) = PointBatch<T, DIM, W>(points + i).squaredDistance(q);
+
+    if (i < count)
+      Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>(distances + i, count - i) = PointBatch<T, DIM, W>(points + i, count - i).squaredDistance(q).head(count - i);
+  }
+
+
+  template <int W, typename T, uint8_t DIM>
+  inline size_t nearest(const PointBatch<T, DIM, W>* batches, size_t count, const Eigen::Matrix<T, int(DIM), 1>& query){
+    return nearestBatch<W>([batches](size_t i){ return batches[i / W]; }, count, query);
+  }
+
+
+  template <int W, typename T, uint8_t DIM>
+  inline size_t nearest(const Point<T, DIM>* points, size_t count, const Eigen::Matrix<T, int(DIM), 1>& query){
+    return nearestBatch<W>([points, count](size_t i){ return PointBatch<T, DIM, W>(points + i, std::min<size_t>(W, count - i)); }, count, query);
+  }
+
+} // namespace geo
+
+
+#endif // POINT_BATCH_H
@@ -0,0 +1,102 @@
+#ifndef RAY_H
+#define RAY_H
+
+#include <algorithm>
+#include <limits>
+
+#include <Eigen/Geometry>
+
+namespace geo {
+
+  /** STRUCT Ray
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * Half-line origin + t * direction, restricted to t in [t_min, t_max]. The inverse of the direction is precomputed for the box tests.
+    * Parameters:
+    *            - origin
+    *            - direction (does not have to be normalized; distances are then measured in units of its length)
+    *            - t_min (default = 0), t_max (default = infinity)
+    */
+
+  template <typename T = float>
+  struct Ray {
+    Eigen::Matrix<T, 3, 1> origin;
+    Eigen::Matrix<T, 3, 1> direction;
+    Eigen::Matrix<T, 3, 1> inverse_direction;
+    T t_min;
+    T t_max;
+
+    Ray(const Eigen::Matrix<T, 3, 1>& origin, const Eigen::Matrix<T, 3, 1>& direction, T t_min = 0, T t_max = std::numeric_limits<T>::infinity()) :
+        origin{origin}, direction{direction}, inverse_direction{direction.cwiseInverse()}, t_min{t_min}, t_max{t_max} {}
+
+    Eigen::Matrix<T, 3, 1> at(T t) const { return origin + t * direction; }
+  };
+
+
+  /** STRUCT RayPacket
+    * Template params:
+    *                 T --> type used for the coordinates
+    *                 W --> number of rays (lanes): 4, 8 or 16 fill one SSE, AVX or AVX-512 register of floats
+    *
+    * W rays stored as structure of arrays: each coordinate of origins and directions is one column of W contiguous lanes, so the intersection
+    * kernels process the W rays with SIMD instructions (Eigen vectorizes the fixed-size arrays with the instruction set enabled in the compiler).
+    */
+
+  template <typename T = float, int W = 8>
+  struct RayPacket {
+    typedef Eigen::Array<T, W, 1> Lanes;
+    typedef Eigen::Array<bool, W, 1> Mask;
+    typedef Eigen::Array<T, W, 3> Vectors;
+
+    Vectors origin;
+    Vectors direction;
+    Lanes t_min;
+    Lanes t_max;
+
+    RayPacket() : origin{Vectors::Zero()}, direction{Vectors::Zero()}, t_min{Lanes::Zero()}, t_max{Lanes::Constant(std::numeric_limits<T>::infinity())} {}
+
+    /**
+      * Loads W consecutive rays
+      */
+    RayPacket(const Ray<T>* rays) {
+      for(int i = 0; i < W; i++)
+        set(i, rays[i]);
+    }
+
+    void set(int lane, const Ray<T>& ray) {
+      origin.row(lane) = ray.origin.transpose().array();
+      direction.row(lane) = ray.direction.transpose().array();
+      t_min[lane] = ray.t_min;
+      t_max[lane] = ray.t_max;
+    }
+  };
+
+
+  /**
+    * Ray - axis-aligned box intersection (slab test). If the ray hits the box within [t_min, t_max], returns true and the entry distance
+    */
+  template <typename T>
+  inline bool intersect(const Ray<T>& ray, const Eigen::AlignedBox<T, 3>& box, T& t);
+
+
+
+
+
+  template <typename T>
+  inline bool intersect(const Ray<T>& ray, const Eigen::AlignedBox<T, 3>& box, T& t){
+    Eigen::Array<T, 3, 1> t1 = (box.min() - ray.origin).array() * ray.inverse_direction.array();
+    Eigen::Array<T, 3, 1> t2 = (box.max() - ray.origin).array() * ray.inverse_direction.array();
+
+    T t_enter = std::max(t1.min(t2).maxCoeff(), ray.t_min);
+    T t_exit = std::min(t1.max(t2).minCoeff(), ray.t_max);
+    if (t_enter > t_exit) return false;
+
+    t = t_enter;
+    return true;
+  }
+
+} // namespace geo
+
+
+#endif // RAY_H
@@ -0,0 +1,235 @@
+#ifndef SCENE_NODE_H
+#define SCENE_NODE_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <functional>
+
+#include <Eigen/Geometry>
+
+#include "cartesian_cs_3d.h"
+#include "shape.h"
+#include "executor.h"
+
+namespace geo {
+
+  /** CLASS SceneNode
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * Node of a hierarchy of coordinate systems. The frame of each node is a CartesianCS_3D expressed in the coordinates of its parent
+    * (the frame of the root is expressed in world coordinates). Shapes attached to a node (not owned) are defined in its coordinates.
+    * The transformation from the coordinates of a node to world coordinates is cached. Changing a frame marks its subtree as dirty
+    * (a dirty node only has dirty descendants, so the marking stops at the first one already dirty), and the world transformations are only
+    * recomputed for dirty nodes: lazily when they are read, or all at once with update(), which splits independent subtrees across threads.
+    * Reading world transformations of dirty nodes from several threads at once is not safe: call update() first.
+    */
+
+  template <typename T = float>
+  class SceneNode {
+  public:
+    typedef Eigen::Transform<T, 3, Eigen::Affine> Transform;
+
+  private:
+    // Independent dirty subtrees wanted by update(executor) to keep the threads busy
+    static constexpr size_t MIN_SUBTREES {16};
+
+    CartesianCS_3D<T> _frame;
+    SceneNode* _parent {nullptr};
+    std::vector<std::unique_ptr<SceneNode>> _children;
+    std::vector<const Shape<T, 3>*> _shapes;
+
+    // Number of nodes in the subtree, including this one
+    size_t _subtree_size {1};
+
+    mutable bool _dirty {true};
+    mutable Transform _world {Transform::Identity()};
+
+    // Transformation from the coordinates of this node to those of its parent: the inverse of the frame matrix
+    Transform localTransform() const {
+      Transform local {Transform::Identity()};
+      for(uint8_t i = 0; i < 3; i++)
+        local.linear().col(i) = _frame[i];
+      local.translation() = _frame.center();
+
+      return local;
+    }
+
+    void markDirty() {
+      if (_dirty) return;
+
+      _dirty = true;
+      for(std::unique_ptr<SceneNode>& child : _children)
+        child->markDirty();
+    }
+
+    void resize(long delta) {
+      for(SceneNode* node = this; node; node = node->_parent)
+        node->_subtree_size += delta;
+    }
+
+    // The parent must be up to date
+    void updateNode() const {
+      _world = _parent ? _parent->_world * localTransform() : localTransform();
+      _dirty = false;
+    }
+
+    void updateSubtree() const {
+      if (_dirty) updateNode();
+
+      for(const std::unique_ptr<SceneNode>& child : _children)
+        child->updateSubtree();
+    }
+
+    /**
+      * Roots of the dirty subtrees below a clean node
+      */
+    void dirtySubtrees(std::vector<const SceneNode*>& roots) const {
+      for(const std::unique_ptr<SceneNode>& child : _children){
+        if (child->_dirty)
+          roots.push_back(child.get());
+        else
+          child->dirtySubtrees(roots);
+      }
+    }
+
+  public:
+    SceneNode(const CartesianCS_3D<T>& frame = CartesianCS_3D<T>()) : _frame{frame} {}
+
+    SceneNode(const SceneNode&) = delete;
+    SceneNode& operator=(const SceneNode&) = delete;
+
+    ~SceneNode() {}
+
+    const CartesianCS_3D<T> & frame() const { return _frame; }
+
+    /**
+      * Moves the node (and its subtree) relative to its parent
+      */
+    void setFrame(const CartesianCS_3D<T>& frame) {
+      _frame = frame;
+      markDirty();
+    }
+
+    SceneNode* parent() const { return _parent; }
+
+    const std::vector<std::unique_ptr<SceneNode>> & children() const { return _children; }
+
+    size_t subtreeSize() const { return _subtree_size; }
+
+    /**
+      * Creates a child node and returns it (owned by this node)
+      */
+    SceneNode& addChild(const CartesianCS_3D<T>& frame = CartesianCS_3D<T>()) {
+      return addChild(std::unique_ptr<SceneNode>(new SceneNode(frame)));
+    }
+
+    SceneNode& addChild(std::unique_ptr<SceneNode> child) {
+      child->_parent = this;
+      child->_dirty = false;
+      child->markDirty();
+      resize(child->_subtree_size);
+
+      _children.push_back(std::move(child));
+      return *_children.back();
+    }
+
+    /**
+      * Detaches a child node and returns it as a root
+      */
+    std::unique_ptr<SceneNode> removeChild(SceneNode* child) {
+      auto it = std::find_if(_children.begin(), _children.end(), [&](const std::unique_ptr<SceneNode>& c){ return c.get() == child; });
+      if (it == _children.end()) return nullptr;
+
+      std::unique_ptr<SceneNode> removed = std::move(*it);
+      _children.erase(it);
+      resize(-static_cast<long>(removed->_subtree_size));
+
+      removed->_parent = nullptr;
+      removed->_dirty = false;
+      removed->markDirty();
+      return removed;
+    }
+
+    /**
+      * Shapes defined in the coordinates of this node (not owned: they must outlive the node)
+      */
+    void attach(const Shape<T, 3>* shape) { _shapes.push_back(shape); }
+
+    void detach(const Shape<T, 3>* shape) { _shapes.erase(std::remove(_shapes.begin(), _shapes.end(), shape), _shapes.end()); }
+
+    const std::vector<const Shape<T, 3>*> & shapes() const { return _shapes; }
+
+    bool dirty() const { return _dirty; }
+
+    /**
+      * Transformation from the coordinates of this node to world coordinates (recomputed, with its dirty ancestors, if needed)
+      */
+    const Transform & worldTransform() const {
+      if (_dirty){
+        if (_parent) _parent->worldTransform();
+        updateNode();
+      }
+
+      return _world;
+    }
+
+    /**
+      * World axis-aligned bounding box of an attached shape
+      */
+    Eigen::AlignedBox<T, 3> worldAabb(const Shape<T, 3>& shape) const { return transformBox(shape.aabb(), worldTransform()); }
+
+    /**
+      * Recomputes the world transformations of all the dirty nodes of the subtree
+      */
+    void update() const {
+      worldTransform();
+      updateSubtree();
+    }
+
+    /**
+      * Same as above, with independent dirty subtrees split across the threads of the executor.
+      * Dirty subtrees are collected from the clean part of the tree; while they are too few, the largest one is updated at its root and
+      * replaced by the subtrees of its children
+      */
+    void update(const Executor& executor) const {
+      std::vector<const SceneNode*> roots;
+      worldTransform();
+      dirtySubtrees(roots);
+
+      while(!roots.empty() && roots.size() < MIN_SUBTREES){
+        auto largest = std::max_element(roots.begin(), roots.end(), [](const SceneNode* a, const SceneNode* b){ return a->_subtree_size < b->_subtree_size; });
+        const SceneNode* node = *largest;
+        if (node->_children.empty()) break;
+
+        node->worldTransform();
+        roots.erase(largest);
+        for(const std::unique_ptr<SceneNode>& child : node->_children)
+          roots.push_back(child.get());
+      }
+
+      size_t nodes {0};
+      for(const SceneNode* root : roots)
+        nodes += root->_subtree_size;
+
+      executor.parallelFor(roots.size(), [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++)
+          roots[i]->updateSubtree();
+      }, roots.empty() ? 1 : nodes / roots.size());
+    }
+
+    /**
+      * Calls "visitor(node)" for every node of the subtree, parents before children
+      */
+    void visit(const std::function<void(const SceneNode&)>& visitor) const {
+      visitor(*this);
+      for(const std::unique_ptr<SceneNode>& child : _children)
+        child->visit(visitor);
+    }
+  }; // class SceneNode
+
+} // namespace geo
+
+
+#endif // SCENE_NODE_H
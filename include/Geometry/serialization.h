@@ -0,0 +1,482 @@
+#ifndef SERIALIZATION_H
+#define SERIALIZATION_H
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+#include <Eigen/Core>
+
+#include "shape_variant.h"
+#include "shape_batch.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #define GEO_MMAP
+#endif
+
+namespace geo {
+
+  enum class ShapeType : uint32_t { NONE = 0, CIRCLE, RECTANGLE, CUBOID, CYLINDER, CONE };
+
+
+  /** STRUCT ShapeFileHeader
+    * Binary shape file (native byte order), made of the header followed by sections aligned to SECTION_ALIGNMENT bytes:
+    *            - records: one ShapeRecord per shape
+    *            - vertices, normals: x, y, z of all the shapes, one after the other
+    *            - mesh vertices (optional): interleaved vertex buffers of the meshes (see Mesh), one after the other
+    *            - indices (optional): uint32 triangle indices of the meshes, relative to the first vertex of their mesh
+    * Offsets are in bytes from the start of the file, counts in elements.
+    */
+
+  struct ShapeFileHeader {
+    static constexpr uint32_t VERSION {2};
+    static constexpr uint64_t SECTION_ALIGNMENT {64};
+
+    char magic[8];
+    uint32_t version;
+    uint32_t scalar_size;
+
+    uint64_t num_shapes;
+    uint64_t num_vertices;
+    uint64_t num_normals;
+    uint64_t num_mesh_vertices;
+    uint64_t num_indices;
+
+    uint64_t records_offset;
+    uint64_t vertices_offset;
+    uint64_t normals_offset;
+    uint64_t mesh_vertices_offset;
+    uint64_t indices_offset;
+  };
+
+
+  /** STRUCT ShapeRecord
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * Type, parameters and ranges of one shape. Parameters by type:
+    *            - CIRCLE: radius, center (3), normal (3)
+    *            - RECTANGLE: width, height, center (3), width axis (3), height axis (3)
+    *            - CUBOID: width, height, depth, center (3), width axis (3), depth axis (3) (the height axis is their cross product)
+    *            - CYLINDER: radius, height, base center (3), top center (3), base normal (3), top normal (3)
+    *            - CONE: radius, height, base center (3), base normal (3)
+    *            - NONE (shapes of a ShapeBatch): no parameters
+    */
+
+  template <typename T = float>
+  struct ShapeRecord {
+    static constexpr size_t NUM_PARAMETERS {16};
+
+    uint32_t type;
+    uint32_t reserved;
+
+    uint64_t first_vertex;
+    uint64_t num_vertices;
+    uint64_t first_normal;
+    uint64_t num_normals;
+    uint64_t first_mesh_vertex;
+    uint64_t num_mesh_vertices;
+    uint64_t first_index;
+    uint64_t num_indices;
+
+    T parameters[NUM_PARAMETERS];
+  };
+
+
+  /** CLASS ShapeWriter
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * Collects shapes (with their vertices and normals already transformed) and writes them as a shape file.
+    * Parameters:
+    *            - meshes: also write the triangle mesh of every shape (default = false)
+    */
+
+  template <typename T = float>
+  class ShapeWriter {
+    bool _meshes;
+
+    std::vector<ShapeRecord<T>> _records;
+    std::vector<T> _vertices;
+    std::vector<T> _normals;
+    std::vector<T> _mesh_vertices;
+    std::vector<uint32_t> _indices;
+
+    ShapeRecord<T>& record(ShapeType type, const Shape<T, 3>& shape) {
+      ShapeRecord<T> r {};
+      r.type = static_cast<uint32_t>(type);
+      r.first_vertex = _vertices.size() / 3;
+      r.num_vertices = shape.size();
+      r.first_normal = _normals.size() / 3;
+      r.num_normals = shape.normals().size();
+      r.first_mesh_vertex = _mesh_vertices.size() / Mesh<T>::VERTEX_SIZE;
+      r.first_index = _indices.size();
+
+      _vertices.insert(_vertices.end(), shape.data(), shape.data() + 3 * r.num_vertices);
+      _normals.insert(_normals.end(), shape.normalsData(), shape.normalsData() + 3 * r.num_normals);
+
+      _records.push_back(r);
+      return _records.back();
+    }
+
+    template <typename SHAPE>
+    void mesh(const SHAPE& shape, ShapeRecord<T>& r) {
+      if (!_meshes) return;
+
+      MeshSize size = shape.meshSize();
+      r.num_mesh_vertices = size.vertices;
+      r.num_indices = size.indices;
+
+      _mesh_vertices.resize(_mesh_vertices.size() + size.vertices * Mesh<T>::VERTEX_SIZE);
+      _indices.resize(_indices.size() + size.indices);
+      shape.toMesh(_mesh_vertices.data() + r.first_mesh_vertex * Mesh<T>::VERTEX_SIZE, _indices.data() + r.first_index);
+    }
+
+    static void parameters(T* p, const Eigen::Matrix<T, 3, 1>& v) { p[0] = v.x(); p[1] = v.y(); p[2] = v.z(); }
+
+    static void write(std::ostream& os, const void* data, size_t bytes) {
+      os.write(static_cast<const char*>(data), bytes);
+    }
+
+    static void pad(std::ostream& os, uint64_t& offset) {
+      static const char zeros[ShapeFileHeader::SECTION_ALIGNMENT] {};
+      uint64_t padding = (ShapeFileHeader::SECTION_ALIGNMENT - offset % ShapeFileHeader::SECTION_ALIGNMENT) % ShapeFileHeader::SECTION_ALIGNMENT;
+      write(os, zeros, padding);
+      offset += padding;
+    }
+
+  public:
+    ShapeWriter(bool meshes = false) : _meshes{meshes} {}
+
+    ~ShapeWriter() {}
+
+    size_t size() const { return _records.size(); }
+
+    void add(const Circle<T>& circle) {
+      ShapeRecord<T>& r = record(ShapeType::CIRCLE, circle);
+      r.parameters[0] = circle.radius();
+      parameters(r.parameters + 1, circle.center());
+      parameters(r.parameters + 4, circle.normal());
+      mesh(circle, r);
+    }
+
+    void add(const Rectangle<T>& rectangle) {
+      ShapeRecord<T>& r = record(ShapeType::RECTANGLE, rectangle);
+      r.parameters[0] = rectangle.width();
+      r.parameters[1] = rectangle.height();
+      parameters(r.parameters + 2, rectangle.center());
+      parameters(r.parameters + 5, rectangle.width_axis());
+      parameters(r.parameters + 8, rectangle.height_axis());
+      mesh(rectangle, r);
+    }
+
+    void add(const Cuboid<T>& cuboid) {
+      ShapeRecord<T>& r = record(ShapeType::CUBOID, cuboid);
+      r.parameters[0] = cuboid.width();
+      r.parameters[1] = cuboid.height();
+      r.parameters[2] = cuboid.depth();
+      parameters(r.parameters + 3, cuboid.center());
+      parameters(r.parameters + 6, cuboid.width_axis());
+      parameters(r.parameters + 9, cuboid.depth_axis());
+      mesh(cuboid, r);
+    }
+
+    void add(const Cylinder<T>& cylinder) {
+      ShapeRecord<T>& r = record(ShapeType::CYLINDER, cylinder);
+      r.parameters[0] = cylinder.radius();
+      r.parameters[1] = cylinder.height();
+      parameters(r.parameters + 2, cylinder.base_center());
+      parameters(r.parameters + 5, cylinder.top_center());
+      parameters(r.parameters + 8, cylinder.base_normal());
+      parameters(r.parameters + 11, cylinder.top_normal());
+      mesh(cylinder, r);
+    }
+
+    void add(const Cone<T>& cone) {
+      ShapeRecord<T>& r = record(ShapeType::CONE, cone);
+      r.parameters[0] = cone.radius();
+      r.parameters[1] = cone.height();
+      parameters(r.parameters + 2, cone.base_center());
+      parameters(r.parameters + 5, cone.base_normal());
+      mesh(cone, r);
+    }
+
+    void add(const ShapeVariant<T>& shape) {
+      std::visit([this](const auto& s){ add(s); }, shape);
+    }
+
+    /**
+      * Shapes of a batch: vertices and normals only (type NONE)
+      */
+    void add(const ShapeBatch<T>& batch) {
+      for(size_t i = 0; i < batch.size(); i++){
+        const typename ShapeBatch<T>::Range& range = batch.range(i);
+
+        ShapeRecord<T> r {};
+        r.type = static_cast<uint32_t>(ShapeType::NONE);
+        r.first_vertex = _vertices.size() / 3;
+        r.num_vertices = range.num_vertices;
+        r.first_normal = _normals.size() / 3;
+        r.num_normals = range.num_normals;
+        r.first_mesh_vertex = _mesh_vertices.size() / Mesh<T>::VERTEX_SIZE;
+        r.first_index = _indices.size();
+
+        _vertices.insert(_vertices.end(), batch.vertices(i)->data(), batch.vertices(i)->data() + 3 * range.num_vertices);
+        _normals.insert(_normals.end(), batch.normals(i)->data(), batch.normals(i)->data() + 3 * range.num_normals);
+        _records.push_back(r);
+      }
+    }
+
+    void clear() {
+      _records.clear();
+      _vertices.clear();
+      _normals.clear();
+      _mesh_vertices.clear();
+      _indices.clear();
+    }
+
+    void write(std::ostream& os) const {
+      ShapeFileHeader header {};
+      std::memcpy(header.magic, "GEOSHAPE", sizeof(header.magic));
+      header.version = ShapeFileHeader::VERSION;
+      header.scalar_size = sizeof(T);
+      header.num_shapes = _records.size();
+      header.num_vertices = _vertices.size() / 3;
+      header.num_normals = _normals.size() / 3;
+      header.num_mesh_vertices = _mesh_vertices.size() / Mesh<T>::VERTEX_SIZE;
+      header.num_indices = _indices.size();
+
+      // Section offsets
+      uint64_t offset = sizeof(ShapeFileHeader);
+      uint64_t* offsets[] {&header.records_offset, &header.vertices_offset, &header.normals_offset, &header.mesh_vertices_offset, &header.indices_offset};
+      uint64_t bytes[] {_records.size() * sizeof(ShapeRecord<T>), _vertices.size() * sizeof(T), _normals.size() * sizeof(T),
+                        _mesh_vertices.size() * sizeof(T), _indices.size() * sizeof(uint32_t)};
+      for(size_t i = 0; i < 5; i++){
+        offset += (ShapeFileHeader::SECTION_ALIGNMENT - offset % ShapeFileHeader::SECTION_ALIGNMENT) % ShapeFileHeader::SECTION_ALIGNMENT;
+        *offsets[i] = offset;
+        offset += bytes[i];
+      }
+
+      offset = 0;
+      write(os, &header, sizeof(header));
+      offset += sizeof(header);
+      const void* data[] {_records.data(), _vertices.data(), _normals.data(), _mesh_vertices.data(), _indices.data()};
+      for(size_t i = 0; i < 5; i++){
+        pad(os, offset);
+        write(os, data[i], bytes[i]);
+        offset += bytes[i];
+      }
+
+      if (!os) throw std::runtime_error("Error writing the shape file.");
+    }
+
+    void write(const std::string& path) const {
+      std::ofstream os(path, std::ios::binary | std::ios::trunc);
+      if (!os) throw std::runtime_error("Cannot open " + path + " for writing.");
+      write(os);
+    }
+  }; // class ShapeWriter
+
+
+  /** CLASS ShapeView
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * Read-only view of one shape of a MappedShapes: pointers into the file, valid while it is open
+    */
+
+  template <typename T = float>
+  class ShapeView {
+    const ShapeRecord<T>* _record;
+    const T* _vertices;
+    const T* _normals;
+    const T* _mesh_vertices;
+    const uint32_t* _indices;
+
+  public:
+    ShapeView(const ShapeRecord<T>* record, const T* vertices, const T* normals, const T* mesh_vertices, const uint32_t* indices) :
+        _record{record}, _vertices{vertices}, _normals{normals}, _mesh_vertices{mesh_vertices}, _indices{indices} {}
+
+    ShapeType type() const { return static_cast<ShapeType>(_record->type); }
+
+    // See ShapeRecord
+    const T* parameters() const { return _record->parameters; }
+
+    size_t size() const { return _record->num_vertices; }
+    const T* data() const { return _vertices; }
+    Eigen::Map<const Eigen::Matrix<T, 3, Eigen::Dynamic>> vertices() const { return {_vertices, 3, static_cast<Eigen::Index>(size())}; }
+
+    size_t numNormals() const { return _record->num_normals; }
+    const T* normalsData() const { return _normals; }
+    Eigen::Map<const Eigen::Matrix<T, 3, Eigen::Dynamic>> normals() const { return {_normals, 3, static_cast<Eigen::Index>(numNormals())}; }
+
+    // Mesh (if written): interleaved vertex buffer (see Mesh) and triangle indices
+    bool hasMesh() const { return _record->num_indices > 0; }
+    size_t meshSize() const { return _record->num_mesh_vertices; }
+    const T* meshData() const { return _mesh_vertices; }
+    size_t numIndices() const { return _record->num_indices; }
+    const uint32_t* indices() const { return _indices; }
+  }; // class ShapeView
+
+
+  /** CLASS MappedShapes
+    * Template params:
+    *                 T --> type used for the coordinates (same as the one of the file)
+    *
+    * Shape file mapped into memory (mmap, read-only; read into a buffer on systems without it): shapes are accessed in place, with no parsing
+    * and no copy, and pages are only loaded when they are touched.
+    */
+
+  template <typename T = float>
+  class MappedShapes {
+    const char* _data {nullptr};
+    size_t _length {0};
+    bool _mapped {false};
+    std::vector<char> _buffer;
+
+    const ShapeFileHeader* _header {nullptr};
+
+    template <typename E>
+    const E* section(uint64_t offset) const { return reinterpret_cast<const E*>(_data + offset); }
+
+    void checkSection(uint64_t offset, uint64_t count, size_t element_size) const {
+      if (offset % ShapeFileHeader::SECTION_ALIGNMENT != 0 || offset > _length || count > (_length - offset) / element_size)
+        throw std::invalid_argument("Corrupted shape file: section out of bounds.");
+    }
+
+    void load() {
+      if (_length < sizeof(ShapeFileHeader) || std::memcmp(_data, "GEOSHAPE", 8) != 0)
+        throw std::invalid_argument("Not a shape file.");
+
+      _header = section<ShapeFileHeader>(0);
+      if (_header->version != ShapeFileHeader::VERSION)
+        throw std::invalid_argument("Unsupported shape file version (or byte order).");
+      if (_header->scalar_size != sizeof(T))
+        throw std::invalid_argument("Shape file written with another coordinate type.");
+
+      checkSection(_header->records_offset, _header->num_shapes, sizeof(ShapeRecord<T>));
+      checkSection(_header->vertices_offset, _header->num_vertices, 3 * sizeof(T));
+      checkSection(_header->normals_offset, _header->num_normals, 3 * sizeof(T));
+      checkSection(_header->mesh_vertices_offset, _header->num_mesh_vertices, Mesh<T>::VERTEX_SIZE * sizeof(T));
+      checkSection(_header->indices_offset, _header->num_indices, sizeof(uint32_t));
+    }
+
+    void release() {
+#ifdef GEO_MMAP
+      if (_mapped) munmap(const_cast<char*>(_data), _length);
+#endif
+      _data = nullptr;
+      _length = 0;
+      _mapped = false;
+      _buffer.clear();
+      _header = nullptr;
+    }
+
+  public:
+    explicit MappedShapes(const std::string& path) {
+#ifdef GEO_MMAP
+      int fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0) throw std::runtime_error("Cannot open " + path + ".");
+
+      struct stat st;
+      if (fstat(fd, &st) != 0){
+        close(fd);
+        throw std::runtime_error("Cannot read " + path + ".");
+      }
+
+      _length = st.st_size;
+      void* address = _length ? mmap(nullptr, _length, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+      close(fd);
+      if (address == MAP_FAILED) throw std::runtime_error("Cannot map " + path + ".");
+
+      _data = static_cast<const char*>(address);
+      _mapped = true;
+#else
+      std::ifstream is(path, std::ios::binary | std::ios::ate);
+      if (!is) throw std::runtime_error("Cannot open " + path + ".");
+
+      _buffer.resize(is.tellg());
+      is.seekg(0);
+      if (!is.read(_buffer.data(), _buffer.size())) throw std::runtime_error("Cannot read " + path + ".");
+
+      _data = _buffer.data();
+      _length = _buffer.size();
+#endif
+
+      try{
+        load();
+      }
+      catch(...){
+        release();
+        throw;
+      }
+    }
+
+    MappedShapes(const MappedShapes&) = delete;
+    MappedShapes& operator=(const MappedShapes&) = delete;
+
+    MappedShapes(MappedShapes&& m) noexcept : _data{m._data}, _length{m._length}, _mapped{m._mapped}, _buffer{std::move(m._buffer)}, _header{m._header} {
+      m._data = nullptr;
+      m._length = 0;
+      m._mapped = false;
+      m._header = nullptr;
+    }
+
+    ~MappedShapes() { release(); }
+
+    // Number of shapes
+    size_t size() const { return _header->num_shapes; }
+
+    const ShapeFileHeader& header() const { return *_header; }
+
+    ShapeView<T> operator[](size_t shape) const {
+      if (shape >= size()) throw std::out_of_range("Shape index out of range.");
+
+      const ShapeRecord<T>* r = section<ShapeRecord<T>>(_header->records_offset) + shape;
+      if (r->first_vertex + r->num_vertices > _header->num_vertices || r->first_normal + r->num_normals > _header->num_normals ||
+          r->first_mesh_vertex + r->num_mesh_vertices > _header->num_mesh_vertices || r->first_index + r->num_indices > _header->num_indices)
+        throw std::invalid_argument("Corrupted shape file: shape out of bounds.");
+
+      return ShapeView<T>(r, vertexData() + 3 * r->first_vertex, normalsData() + 3 * r->first_normal,
+                          meshData() + Mesh<T>::VERTEX_SIZE * r->first_mesh_vertex, indices() + r->first_index);
+    }
+
+    /**
+      * Whole sections, e.g. to upload all the shapes at once
+      */
+    size_t numVertices() const { return _header->num_vertices; }
+    const T* vertexData() const { return section<T>(_header->vertices_offset); }
+
+    size_t numNormals() const { return _header->num_normals; }
+    const T* normalsData() const { return section<T>(_header->normals_offset); }
+
+    size_t meshSize() const { return _header->num_mesh_vertices; }
+    const T* meshData() const { return section<T>(_header->mesh_vertices_offset); }
+
+    size_t numIndices() const { return _header->num_indices; }
+    const uint32_t* indices() const { return section<uint32_t>(_header->indices_offset); }
+
+    /**
+      * Copies the vertices and normals of all the shapes into a batch (one range per shape)
+      */
+    void toBatch(ShapeBatch<T>& batch) const {
+      batch.reserve(batch.size() + size(), batch.vertices().size() + numVertices(), batch.normals().size() + numNormals());
+      for(size_t i = 0; i < size(); i++){
+        ShapeView<T> view = (*this)[i];
+        batch.add(view.data(), view.size(), view.normalsData(), view.numNormals());
+      }
+    }
+  }; // class MappedShapes
+
+} // namespace geo
+
+#undef GEO_MMAP
+
+#endif // SERIALIZATION_H
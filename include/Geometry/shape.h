@@ -1,106 +1,314 @@
-#ifndef SHAPE_H
-#define SHAPE_H
-
-#include <vector>
-
-#include "point.h"
-
-namespace geo {
-
-  /** ABSTRACT CLASS Shape
-    * Template params:
-    *                 T --> type used for the coordinates
-    *                 DIM --> Number of dimensions
-    */
-
-  template <typename T = float, uint8_t DIM = 2>
-  class Shape{
-
-  protected:
-    std::vector<Point<T, DIM>> _vertices;
-
-    std::vector<Eigen::Matrix<T, DIM, 1>> _normals;
-
-  public:
-    Shape(){};
-
-    Shape(const Shape& s) : _vertices{s._vertices}, _normals{s._normals} {};
-
-    ~Shape(){}
-
-    size_t size() const { return this->_vertices.size(); }
-
-    const std::vector<Point<T, DIM>> & vertices() const { return this->_vertices; }
-    const T* data() const { return this->_vertices.data()->data(); }
-
-    const std::vector<Eigen::Matrix<T, DIM, 1>> & normals() const { return this->_normals; }
-    const T* normalsData() const { return this->_normals.data()->data(); }
-
-    virtual T area() const = 0;
-    virtual T volume() const = 0;
-
-    const Point<T, DIM>& operator[](size_t pos) const { return _vertices.at(pos); }
-
-    void scale3D(T scale){
-      scale3D(scale, scale, scale);
-    }
-
-    void scale3D(T scale_X, T scale_Y, T scale_Z){
-      Eigen::Transform<T, 3, Eigen::Affine> scale_matrix(Eigen::Scaling(scale_X, scale_Y, scale_Z));
-
-      typename std::vector<Point<T, 3>>::iterator vert_it = _vertices.begin();
-      while(vert_it != _vertices.end()){
-        *vert_it = scale_matrix * (*vert_it);
-        vert_it++;
-      }
-
-      scale_matrix = scale_matrix.inverse();
-      typename std::vector<Eigen::Matrix<T, 3, 1>>::iterator norm_it = _normals.begin();
-      while(norm_it != _normals.end()){
-        *norm_it = scale_matrix * (*norm_it);
-        (*norm_it).normalize();
-        norm_it++;
-      }
-    }
-
-    void rotate2D(T angle) {
-      if (DIM != 2) throw std::string("2D Rotation can only be applied to 2D Shapes");
-
-      Eigen::Rotation2D<T> rotation_matrix(angle);
-
-      typename std::vector<Point<T, 2>>::iterator vert_it = _vertices.begin();
-      while(vert_it != _vertices.end()){
-        *vert_it = rotation_matrix * (*vert_it);
-        vert_it++;
-      }
-
-      typename std::vector<Eigen::Matrix<T, 2, 1>>::iterator norm_it = _normals.begin();
-      while(norm_it != _normals.end()){
-        *norm_it = rotation_matrix * (*norm_it);
-        norm_it++;
-      }
-    }
-
-    virtual void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis) {
-      if (DIM != 3) throw std::string("3D Rotation can only be applied to 3D Shapes");
-
-      Eigen::AngleAxis<T> rotation_matrix(angle, axis);
-
-      typename std::vector<Point<T, 3>>::iterator vert_it = _vertices.begin();
-      while(vert_it != _vertices.end()){
-        *vert_it = rotation_matrix * (*vert_it);
-        vert_it++;
-      }
-
-      typename std::vector<Eigen::Matrix<T, 3, 1>>::iterator norm_it = _normals.begin();
-      while(norm_it != _normals.end()){
-        *norm_it = rotation_matrix * (*norm_it);
-        norm_it++;
-      }
-    }
-  }; // class Shape
-
-} // namespace geo
-
-
-#endif // SHAPE_H
+#ifndef SHAPE_H
+#define SHAPE_H
+
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <memory_resource>
+
+#include "point.h"
+#include "transformations.h"
+#include "bounds.h"
+#include "mesh.h"
+#include "ray.h"
+#include "instrumentation.h"
+
+namespace geo {
+
+  /** ABSTRACT CLASS Shape
+    * Template params:
+    *                 T --> type used for the coordinates
+    *                 DIM --> Number of dimensions
+    *
+    * Transformations (scale3D, rotate2D, rotate3D, transform) are accumulated in a single affine matrix. In the default (immediate) mode the matrix is
+    * applied right away. In deferred mode (deferTransforms(true)) it is only applied, in one single pass over vertices and normals,
+    * the next time they are read.
+    * Transformations taking an Executor split the pass across threads. rotate3D has no such overload (derived shapes override it):
+    * rotations can be deferred and then applied with applyTransform(executor).
+    *
+    * The axis-aligned bounding box and the bounding sphere are cached. Derived shapes with analytic bounds compute them from their parameters,
+    * which follow rotate3D but not scale3D/transform. Any transformation invalidates the cache: other shapes (and scaled ones) rescan their
+    * vertices on the next request, with the pending transformation applied once to their bounds in deferred mode.
+    * Ray intersections are computed from the same parameters, and from the triangle mesh (cached until the next transformation) once they do not
+    * describe the shape anymore.
+    * Const member functions can be called from several threads at once: the pending transformation is applied, and the cached bounds and mesh
+    * are built, by only one of them. Transformations need exclusive access to the shape.
+    * Vertices and normals are allocated from the memory resource given to the constructor (e.g. a per-frame std::pmr::monotonic_buffer_resource
+    * or a pool), or from the default one. Copies use the default resource unless another one is given.
+    */
+
+  template <typename T = float, uint8_t DIM = 2>
+  class Shape{
+  public:
+    typedef std::pmr::polymorphic_allocator<std::byte> allocator_type;
+
+  protected:
+    mutable std::pmr::vector<Point<T, DIM>> _vertices;
+
+    mutable std::pmr::vector<Eigen::Matrix<T, DIM, 1>> _normals;
+
+  private:
+    bool _deferred {false};
+
+    // Transformation accumulated and not yet applied to vertices and normals
+    mutable std::atomic<bool> _pending {false};
+    mutable Eigen::Transform<T, DIM, Eigen::Affine> _transform {Eigen::Transform<T, DIM, Eigen::Affine>::Identity()};
+
+    // True once a transformation other than a rotation has been applied: the parameters of derived shapes do not describe it anymore
+    bool _scaled {false};
+
+    mutable std::atomic<bool> _bounds_valid {false};
+    mutable Eigen::AlignedBox<T, DIM> _aabb;
+    mutable BoundingSphere<T, DIM> _sphere;
+
+    // Triangle mesh used for ray intersections once the shape is scaled (built on demand, shared by copies, dropped by any transformation)
+    mutable std::shared_ptr<const Mesh<T, uint32_t>> _mesh;
+
+    // Serializes the updates made by const member functions (pending transformation and bounds). Recursive: derived analyticBounds may read vertices
+    mutable std::recursive_mutex _mutex;
+
+    void computeBounds() const {
+      std::lock_guard<std::recursive_mutex> lock(_mutex);
+      if (_bounds_valid) return;
+
+      if (!_scaled && hasAnalyticBounds())
+        analyticBounds(_aabb, _sphere);
+      else {
+        // Vertices not transformed yet: the pending transformation is applied to their bounds
+        _aabb = boundingBox(_vertices.data(), _vertices.size());
+        _sphere = geo::boundingSphere(_vertices.data(), _vertices.size(), Eigen::Matrix<T, DIM, 1>(_aabb.center()));
+        if (_pending){
+          _aabb = transformBox(_aabb, _transform);
+          _sphere = transformSphere(_sphere, _transform);
+        }
+      }
+
+      _bounds_valid = true;
+    }
+
+    // The bounds are recomputed on demand: transforming the cached box again after each rotation would make it grow without limit
+    void updateBounds(bool rotation){
+      _bounds_valid = false;
+
+      if (!rotation) _scaled = true;
+    }
+
+    void accumulate(const Eigen::Transform<T, DIM, Eigen::Affine>& matrix, bool rotation){
+      updateBounds(rotation);
+      _mesh.reset();
+
+      _transform = matrix * _transform;
+      _pending = true;
+    }
+
+    // Copies the state of "s", locked against a concurrent flush (vertices and normals keep the allocator of this shape)
+    void copy(const Shape& s) {
+      std::lock_guard<std::recursive_mutex> lock(s._mutex);
+
+      _vertices.assign(s._vertices.begin(), s._vertices.end());
+      _normals.assign(s._normals.begin(), s._normals.end());
+      _deferred = s._deferred;
+      _pending = s._pending.load();
+      _transform = s._transform;
+      _scaled = s._scaled;
+      _bounds_valid = s._bounds_valid.load();
+      _aabb = s._aabb;
+      _sphere = s._sphere;
+      _mesh = std::atomic_load(&s._mesh);
+    }
+
+  protected:
+    /**
+      * Derived shapes whose bounds can be calculated from their parameters override both
+      */
+    virtual bool hasAnalyticBounds() const { return false; }
+    virtual void analyticBounds(Eigen::AlignedBox<T, DIM>&, BoundingSphere<T, DIM>&) const {}
+
+    // False while the parameters of derived shapes (centers, normals, sizes) describe the transformed shape
+    bool scaled() const { return _scaled; }
+
+    /**
+      * Cached triangle mesh, built with "build" (e.g. the toMesh() of the derived shape) the first time it is needed after a transformation.
+      *   Concurrent callers may both build it, but only one mesh is kept
+      */
+    template <typename BUILD>
+    const Mesh<T, uint32_t>& cachedMesh(BUILD build) const {
+      std::shared_ptr<const Mesh<T, uint32_t>> mesh {std::atomic_load(&_mesh)};
+      if (!mesh){
+        std::shared_ptr<const Mesh<T, uint32_t>> built {std::make_shared<const Mesh<T, uint32_t>>(build())};
+        if (std::atomic_compare_exchange_strong(&_mesh, &mesh, built)) mesh = built;
+      }
+
+      return *mesh;
+    }
+
+    // Allocates the vertices and normals of derived shapes (counted as buffer requests, whatever the memory resource does with them)
+    void allocate(size_t num_vertices, size_t num_normals) {
+      _vertices.resize(num_vertices);
+      _normals.resize(num_normals);
+
+      GEO_COUNT(BUFFER_REQUESTS, (num_vertices > 0) + (num_normals > 0));
+      GEO_COUNT(BYTES_REQUESTED, num_vertices * sizeof(Point<T, DIM>) + num_normals * sizeof(Eigen::Matrix<T, DIM, 1>));
+    }
+
+  public:
+    explicit Shape(const allocator_type& alloc = {}) : _vertices(alloc), _normals(alloc) {};
+
+    Shape(const Shape& s, const allocator_type& alloc = {}) : _vertices(alloc), _normals(alloc) { copy(s); };
+
+    // Eigen::Transform has no noexcept move: written out so that containers of shapes move them instead of copying them
+    Shape(Shape&& s) noexcept : _vertices{std::move(s._vertices)}, _normals{std::move(s._normals)}, _deferred{s._deferred}, _pending{s._pending.load()},
+                                _transform{s._transform}, _scaled{s._scaled}, _bounds_valid{s._bounds_valid.load()}, _aabb{s._aabb}, _sphere{s._sphere},
+                                _mesh{std::move(s._mesh)} {};
+
+    Shape& operator=(const Shape& s) {
+      if (this != &s) copy(s);
+      return *this;
+    }
+
+    Shape& operator=(Shape&& s) {
+      _vertices = std::move(s._vertices);
+      _normals = std::move(s._normals);
+      _deferred = s._deferred;
+      _pending = s._pending.load();
+      _transform = s._transform;
+      _scaled = s._scaled;
+      _bounds_valid = s._bounds_valid.load();
+      _aabb = s._aabb;
+      _sphere = s._sphere;
+      _mesh = std::move(s._mesh);
+      return *this;
+    }
+
+    virtual ~Shape(){}
+
+    size_t size() const { return this->_vertices.size(); }
+
+    allocator_type get_allocator() const { return _vertices.get_allocator(); }
+
+    const std::pmr::vector<Point<T, DIM>> & vertices() const { applyTransform(); return this->_vertices; }
+    const T* data() const { applyTransform(); return this->_vertices.data()->data(); }
+
+    const std::pmr::vector<Eigen::Matrix<T, DIM, 1>> & normals() const { applyTransform(); return this->_normals; }
+    const T* normalsData() const { applyTransform(); return this->_normals.data()->data(); }
+
+    virtual T area() const = 0;
+    virtual T volume() const = 0;
+
+    /**
+      * Distance along the ray to the first point of the shape within [ray.t_min, ray.t_max], if any
+      */
+    virtual bool intersect(const Ray<T>& ray, T& t) const = 0;
+
+    const Point<T, DIM>& operator[](size_t pos) const { applyTransform(); return _vertices.at(pos); }
+
+    const Eigen::AlignedBox<T, DIM> & aabb() const {
+      if (!_bounds_valid) computeBounds();
+      return _aabb;
+    }
+
+    const BoundingSphere<T, DIM> & boundingSphere() const {
+      if (!_bounds_valid) computeBounds();
+      return _sphere;
+    }
+
+    /**
+      * Enables/disables the deferred transform mode. Disabling it applies any pending transformation
+      */
+    void deferTransforms(bool deferred) {
+      _deferred = deferred;
+      if (!_deferred) applyTransform();
+    }
+
+    bool transformsDeferred() const { return _deferred; }
+
+    /**
+      * Applies the accumulated transformation to the vertices, and its inverse-transpose to the normals, in one single pass
+      */
+    void applyTransform() const {
+      if (!_pending) return;
+
+      std::lock_guard<std::recursive_mutex> lock(_mutex);
+      if (!_pending) return;
+
+      GEO_SCOPED_TIMER(TRANSFORM_PASS);
+
+      transformPoints(_transform, _vertices.data(), _vertices.data() + _vertices.size());
+      transformNormals(Eigen::Matrix<T, DIM, DIM>(_transform.linear().inverse().transpose()), _normals.data(), _normals.data() + _normals.size());
+
+      _transform.setIdentity();
+      _pending = false;
+    }
+
+    /**
+      * Same as above, with vertices and normals split across the threads of the executor
+      */
+    void applyTransform(const Executor& executor) const {
+      if (!_pending) return;
+
+      std::lock_guard<std::recursive_mutex> lock(_mutex);
+      if (!_pending) return;
+
+      GEO_SCOPED_TIMER(TRANSFORM_PASS);
+
+      transformPoints(executor, _transform, _vertices.data(), _vertices.data() + _vertices.size());
+      transformNormals(executor, Eigen::Matrix<T, DIM, DIM>(_transform.linear().inverse().transpose()), _normals.data(), _normals.data() + _normals.size());
+
+      _transform.setIdentity();
+      _pending = false;
+    }
+
+    /**
+      * Generic affine transformation, applied after any other pending one
+      */
+    void transform(const Eigen::Transform<T, DIM, Eigen::Affine>& matrix){
+      accumulate(matrix, false);
+
+      if (!_deferred) applyTransform();
+    }
+
+    void transform(const Eigen::Transform<T, DIM, Eigen::Affine>& matrix, const Executor& executor){
+      accumulate(matrix, false);
+
+      if (!_deferred) applyTransform(executor);
+    }
+
+    void scale3D(T scale){
+      scale3D(scale, scale, scale);
+    }
+
+    void scale3D(T scale_X, T scale_Y, T scale_Z){
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::Scaling(scale_X, scale_Y, scale_Z)));
+    }
+
+    void scale3D(T scale, const Executor& executor){
+      scale3D(scale, scale, scale, executor);
+    }
+
+    void scale3D(T scale_X, T scale_Y, T scale_Z, const Executor& executor){
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::Scaling(scale_X, scale_Y, scale_Z)), executor);
+    }
+
+    void rotate2D(T angle) {
+      if (DIM != 2) throw std::string("2D Rotation can only be applied to 2D Shapes");
+
+      accumulate(Eigen::Transform<T, 2, Eigen::Affine>(Eigen::Rotation2D<T>(angle)), true);
+
+      if (!_deferred) applyTransform();
+    }
+
+    virtual void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis) {
+      if (DIM != 3) throw std::string("3D Rotation can only be applied to 3D Shapes");
+
+      accumulate(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::AngleAxis<T>(angle, axis)), true);
+
+      if (!_deferred) applyTransform();
+    }
+  }; // class Shape
+
+} // namespace geo
+
+
+#endif // SHAPE_H
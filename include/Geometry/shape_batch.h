@@ -0,0 +1,195 @@
+#ifndef SHAPE_BATCH_H
+#define SHAPE_BATCH_H
+
+#include <vector>
+#include <iterator>
+
+#include "shape.h"
+#include "transformations.h"
+#include "executor.h"
+
+namespace geo {
+
+  /** CLASS ShapeBatch
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * Vertices and normals of many 3D shapes stored in one contiguous arena. Each shape added to the batch is identified by its index,
+    * and owns a range of vertices and a range of normals in the arena.
+    * Transformations (shared by all the shapes or one per shape) are applied in one single sweep over the arena, without virtual dispatch.
+    */
+
+  template <typename T = float>
+  class ShapeBatch {
+  public:
+    struct Range {
+      size_t first_vertex;
+      size_t num_vertices;
+      size_t first_normal;
+      size_t num_normals;
+    };
+
+  private:
+    std::vector<Point<T, 3>> _vertices;
+    std::vector<Eigen::Matrix<T, 3, 1>> _normals;
+    std::vector<Range> _ranges;
+
+  public:
+    ShapeBatch() {}
+
+    ~ShapeBatch() {}
+
+    void reserve(size_t num_shapes, size_t num_vertices, size_t num_normals) {
+      _ranges.reserve(num_shapes);
+      _vertices.reserve(num_vertices);
+      _normals.reserve(num_normals);
+    }
+
+    void clear() {
+      _ranges.clear();
+      _vertices.clear();
+      _normals.clear();
+    }
+
+    /**
+      * Generates the vertices and normals of SHAPE straight at the end of the arena, with SHAPE::generate(args..., vertices, normals): "args" are
+      *   all the parameters of generate before the output iterators (e.g. radius, height, base center and number of vertices of a Cylinder).
+      *   No shape is built. Returns the index of the shape in the batch
+      */
+    template <typename SHAPE, typename... ARGS>
+    size_t add(const ARGS&... args) {
+      Range range {_vertices.size(), 0, _normals.size(), 0};
+      SHAPE::generate(args..., std::back_inserter(_vertices), std::back_inserter(_normals));
+      range.num_vertices = _vertices.size() - range.first_vertex;
+      range.num_normals = _normals.size() - range.first_normal;
+      _ranges.push_back(range);
+
+      return _ranges.size() - 1;
+    }
+
+    /**
+      * Copies the vertices and normals of an existing shape at the end of the arena (use the version above for new shapes).
+      *   Returns the index of the shape in the batch
+      */
+    size_t add(const Shape<T, 3>& shape) {
+      _ranges.push_back(Range{_vertices.size(), shape.vertices().size(), _normals.size(), shape.normals().size()});
+      _vertices.insert(_vertices.end(), shape.vertices().begin(), shape.vertices().end());
+      _normals.insert(_normals.end(), shape.normals().begin(), shape.normals().end());
+
+      return _ranges.size() - 1;
+    }
+
+    /**
+      * Same as above, from packed buffers (x, y, z per vertex and per normal)
+      */
+    size_t add(const T* vertices, size_t num_vertices, const T* normals, size_t num_normals) {
+      _ranges.push_back(Range{_vertices.size(), num_vertices, _normals.size(), num_normals});
+      for(size_t i = 0; i < num_vertices; i++)
+        _vertices.emplace_back(vertices[3 * i], vertices[3 * i + 1], vertices[3 * i + 2]);
+      for(size_t i = 0; i < num_normals; i++)
+        _normals.emplace_back(normals[3 * i], normals[3 * i + 1], normals[3 * i + 2]);
+
+      return _ranges.size() - 1;
+    }
+
+    // Number of shapes
+    size_t size() const { return _ranges.size(); }
+
+    const Range& range(size_t shape) const { return _ranges.at(shape); }
+
+    const std::vector<Point<T, 3>> & vertices() const { return _vertices; }
+    const T* data() const { return _vertices.data()->data(); }
+
+    const std::vector<Eigen::Matrix<T, 3, 1>> & normals() const { return _normals; }
+    const T* normalsData() const { return _normals.data()->data(); }
+
+    // Vertices and normals of one shape
+    const Point<T, 3>* vertices(size_t shape) const { return _vertices.data() + _ranges.at(shape).first_vertex; }
+    const Eigen::Matrix<T, 3, 1>* normals(size_t shape) const { return _normals.data() + _ranges.at(shape).first_normal; }
+
+    /**
+      * Transformation of one shape of the batch
+      */
+    void transform(size_t shape, const Eigen::Transform<T, 3, Eigen::Affine>& matrix) {
+      const Range& r = _ranges.at(shape);
+
+      transformPoints(matrix, _vertices.data() + r.first_vertex, _vertices.data() + r.first_vertex + r.num_vertices);
+      transformNormals(Eigen::Matrix<T, 3, 3>(matrix.linear().inverse().transpose()),
+                       _normals.data() + r.first_normal, _normals.data() + r.first_normal + r.num_normals);
+    }
+
+    /**
+      * Same transformation for all the shapes of the batch, in one sweep over the whole arena
+      */
+    void transform(const Eigen::Transform<T, 3, Eigen::Affine>& matrix) {
+      GEO_SCOPED_TIMER(TRANSFORM_PASS);
+      transformPoints(matrix, _vertices.data(), _vertices.data() + _vertices.size());
+      transformNormals(Eigen::Matrix<T, 3, 3>(matrix.linear().inverse().transpose()), _normals.data(), _normals.data() + _normals.size());
+    }
+
+    /**
+      * One transformation per shape ("matrices" must point to size() transformations), in one sweep over the arena
+      */
+    void transform(const Eigen::Transform<T, 3, Eigen::Affine>* matrices) {
+      GEO_SCOPED_TIMER(TRANSFORM_PASS);
+      for(size_t i = 0; i < _ranges.size(); i++)
+        transform(i, matrices[i]);
+    }
+
+    /**
+      * Same as above, with the arena split across the threads of the executor
+      */
+    void transform(size_t shape, const Eigen::Transform<T, 3, Eigen::Affine>& matrix, const Executor& executor) {
+      const Range& r = _ranges.at(shape);
+
+      transformPoints(executor, matrix, _vertices.data() + r.first_vertex, _vertices.data() + r.first_vertex + r.num_vertices);
+      transformNormals(executor, Eigen::Matrix<T, 3, 3>(matrix.linear().inverse().transpose()),
+                       _normals.data() + r.first_normal, _normals.data() + r.first_normal + r.num_normals);
+    }
+
+    void transform(const Eigen::Transform<T, 3, Eigen::Affine>& matrix, const Executor& executor) {
+      GEO_SCOPED_TIMER(TRANSFORM_PASS);
+      transformPoints(executor, matrix, _vertices.data(), _vertices.data() + _vertices.size());
+      transformNormals(executor, Eigen::Matrix<T, 3, 3>(matrix.linear().inverse().transpose()), _normals.data(), _normals.data() + _normals.size());
+    }
+
+    void transform(const Eigen::Transform<T, 3, Eigen::Affine>* matrices, const Executor& executor) {
+      if (_ranges.empty()) return;
+
+      GEO_SCOPED_TIMER(TRANSFORM_PASS);
+
+      executor.parallelFor(_ranges.size(), [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++)
+          transform(i, matrices[i]);
+      }, _vertices.size() / _ranges.size());
+    }
+
+    void scale3D(T scale){
+      scale3D(scale, scale, scale);
+    }
+
+    void scale3D(T scale_X, T scale_Y, T scale_Z){
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::Scaling(scale_X, scale_Y, scale_Z)));
+    }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis) {
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::AngleAxis<T>(angle, axis)));
+    }
+
+    void scale3D(T scale, const Executor& executor){
+      scale3D(scale, scale, scale, executor);
+    }
+
+    void scale3D(T scale_X, T scale_Y, T scale_Z, const Executor& executor){
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::Scaling(scale_X, scale_Y, scale_Z)), executor);
+    }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis, const Executor& executor) {
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::AngleAxis<T>(angle, axis)), executor);
+    }
+  }; // class ShapeBatch
+
+} // namespace geo
+
+
+#endif // SHAPE_BATCH_H
@@ -0,0 +1,128 @@
+#ifndef SHAPE_INSTANCE_H
+#define SHAPE_INSTANCE_H
+
+#include <vector>
+#include <memory>
+
+#include <Eigen/Geometry>
+
+#include "shape.h"
+#include "bounds.h"
+#include "executor.h"
+#include "tessellation_cache.h"
+
+namespace geo {
+
+  /** CLASS ShapeInstance
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * A shared, reference-counted tessellation plus an affine transformation from its local space to world space.
+    * Transformations only update the matrix (O(1)): the vertices are transformed ("baked") on demand, into buffers of the caller.
+    * create<SHAPE>(parameters...) takes the tessellations from the global TessellationCache: instances created with the same shape type and
+    * constructor parameters share the same one.
+    */
+
+  template <typename T = float>
+  class ShapeInstance {
+  public:
+    typedef Eigen::Transform<T, 3, Eigen::Affine> Transform;
+
+  private:
+    std::shared_ptr<const Tessellation<T>> _tessellation;
+    Transform _transform;
+
+  public:
+    ShapeInstance(std::shared_ptr<const Tessellation<T>> tessellation, const Transform& transform = Transform::Identity()) :
+        _tessellation{std::move(tessellation)}, _transform{transform} {}
+
+    ShapeInstance(const ShapeInstance& s) : _tessellation{s._tessellation}, _transform{s._transform} {}
+
+    ~ShapeInstance() {}
+
+    /**
+      * Instance of SHAPE(args...), with its tessellation from the global cache (use the constructor with TessellationCache::get for other caches)
+      */
+    template <typename SHAPE, typename... ARGS>
+    static ShapeInstance create(const ARGS&... args) {
+      return ShapeInstance(TessellationCache<T>::global().template get<SHAPE>(args...));
+    }
+
+    const Tessellation<T> & tessellation() const { return *_tessellation; }
+
+    // Number of instances sharing the tessellation
+    long useCount() const { return _tessellation.use_count(); }
+
+    size_t size() const { return _tessellation->size(); }
+
+    const Transform & transform() const { return _transform; }
+
+    void setTransform(const Transform& transform) { _transform = transform; }
+
+    /**
+      * Transformations, applied after the current one
+      */
+    void transform(const Transform& matrix) { _transform = matrix * _transform; }
+
+    void translate(const Eigen::Matrix<T, 3, 1>& translation) { _transform.pretranslate(translation); }
+
+    void scale3D(T scale) { scale3D(scale, scale, scale); }
+
+    void scale3D(T scale_X, T scale_Y, T scale_Z) { _transform.prescale(Eigen::Matrix<T, 3, 1>(scale_X, scale_Y, scale_Z)); }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1>& axis) { _transform.prerotate(Eigen::AngleAxis<T>(angle, axis)); }
+
+    Eigen::AlignedBox<T, 3> aabb() const { return transformBox(_tessellation->aabb, _transform); }
+
+    /**
+      * Writes the vertices and normals transformed to world space (the buffers must have room for size() of each)
+      */
+    void bake(Point<T, 3>* vertices, Eigen::Matrix<T, 3, 1>* normals) const {
+      size_t n = size();
+      if (n == 0) return;
+
+      Eigen::Map<const Eigen::Matrix<T, 3, Eigen::Dynamic>> local_vertices(_tessellation->vertices.data()->data(), 3, n);
+      Eigen::Map<Eigen::Matrix<T, 3, Eigen::Dynamic>> world_vertices(vertices->data(), 3, n);
+      world_vertices.noalias() = _transform.linear() * local_vertices;
+      world_vertices.colwise() += _transform.translation();
+
+      size_t num_normals = _tessellation->normals.size();
+      if (num_normals == 0) return;
+
+      Eigen::Map<const Eigen::Matrix<T, 3, Eigen::Dynamic>> local_normals(_tessellation->normals.data()->data(), 3, num_normals);
+      Eigen::Map<Eigen::Matrix<T, 3, Eigen::Dynamic>> world_normals(normals->data(), 3, num_normals);
+      world_normals.noalias() = Eigen::Matrix<T, 3, 3>(_transform.linear().inverse().transpose()) * local_normals;
+      world_normals.colwise().normalize();
+    }
+
+    void bake(std::vector<Point<T, 3>>& vertices, std::vector<Eigen::Matrix<T, 3, 1>>& normals) const {
+      vertices.resize(size());
+      normals.resize(_tessellation->normals.size());
+      bake(vertices.data(), normals.data());
+    }
+
+    /**
+      * Bakes many instances into consecutive ranges of the buffers, with the instances split across the threads of the executor
+      */
+    static void bake(const Executor& executor, const ShapeInstance* instances, size_t count, std::vector<Point<T, 3>>& vertices,
+                     std::vector<Eigen::Matrix<T, 3, 1>>& normals) {
+      std::vector<size_t> first_vertex(count + 1, 0);
+      std::vector<size_t> first_normal(count + 1, 0);
+      for(size_t i = 0; i < count; i++){
+        first_vertex[i + 1] = first_vertex[i] + instances[i].size();
+        first_normal[i + 1] = first_normal[i] + instances[i].tessellation().normals.size();
+      }
+
+      vertices.resize(first_vertex[count]);
+      normals.resize(first_normal[count]);
+      executor.parallelFor(count, [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++)
+          instances[i].bake(vertices.data() + first_vertex[i], normals.data() + first_normal[i]);
+      }, count ? first_vertex[count] / count : 1);
+    }
+  }; // class ShapeInstance
+
+} // namespace geo
+
+
+#endif // SHAPE_INSTANCE_H
@@ -0,0 +1,124 @@
+#ifndef SHAPE_VARIANT_H
+#define SHAPE_VARIANT_H
+
+#include <variant>
+#include <type_traits>
+
+#include "Shapes2D/circle.h"
+#include "Shapes2D/rectangle.h"
+#include "Shapes3D/cuboid.h"
+#include "Shapes3D/cylinder.h"
+#include "Shapes3D/cone.h"
+
+namespace geo {
+
+  /** ShapeVariant
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * Any of the 3D shapes, stored by value: containers of variants hold the shapes contiguously, without one heap allocation and one pointer
+    * per shape (vertices and normals are still allocated by each shape).
+    * The functions below dispatch with std::visit and call the member of the concrete type with a qualified (non-virtual) call.
+    * Homogeneous collections (e.g. std::vector<Cylinder<T>>) can use the same qualified calls directly, e.g. cylinder.Cylinder<T>::area().
+    */
+
+  template <typename T = float>
+  using ShapeVariant = std::variant<Circle<T>, Rectangle<T>, Cuboid<T>, Cylinder<T>, Cone<T>>;
+
+  /**
+    * The shape as its base class, for the functions taking a Shape
+    */
+  template <typename T>
+  inline const Shape<T, 3>& asShape(const ShapeVariant<T>& shape);
+
+  template <typename T>
+  inline Shape<T, 3>& asShape(ShapeVariant<T>& shape);
+
+  template <typename T>
+  inline T area(const ShapeVariant<T>& shape);
+
+  template <typename T>
+  inline T volume(const ShapeVariant<T>& shape);
+
+  template <typename T>
+  inline const Eigen::AlignedBox<T, 3>& aabb(const ShapeVariant<T>& shape);
+
+  /**
+    * Distance along the ray to the first point of the shape (see Shape::intersect)
+    */
+  template <typename T>
+  inline bool intersect(const ShapeVariant<T>& shape, const Ray<T>& ray, T& t);
+
+  template <typename T>
+  inline void rotate3D(ShapeVariant<T>& shape, T angle, const Eigen::Matrix<T, 3, 1>& axis);
+
+  template <typename T>
+  inline void transform(ShapeVariant<T>& shape, const Eigen::Transform<T, 3, Eigen::Affine>& matrix);
+
+
+
+
+
+  template <typename T>
+  inline const Shape<T, 3>& asShape(const ShapeVariant<T>& shape){
+    return std::visit([](const auto& s) -> const Shape<T, 3>& { return s; }, shape);
+  }
+
+
+  template <typename T>
+  inline Shape<T, 3>& asShape(ShapeVariant<T>& shape){
+    return std::visit([](auto& s) -> Shape<T, 3>& { return s; }, shape);
+  }
+
+
+  template <typename T>
+  inline T area(const ShapeVariant<T>& shape){
+    return std::visit([](const auto& s){
+      typedef std::decay_t<decltype(s)> SHAPE;
+      return s.SHAPE::area();
+    }, shape);
+  }
+
+
+  template <typename T>
+  inline T volume(const ShapeVariant<T>& shape){
+    return std::visit([](const auto& s){
+      typedef std::decay_t<decltype(s)> SHAPE;
+      return s.SHAPE::volume();
+    }, shape);
+  }
+
+
+  template <typename T>
+  inline const Eigen::AlignedBox<T, 3>& aabb(const ShapeVariant<T>& shape){
+    return asShape(shape).aabb();
+  }
+
+
+  template <typename T>
+  inline bool intersect(const ShapeVariant<T>& shape, const Ray<T>& ray, T& t){
+    return std::visit([&](const auto& s){
+      typedef std::decay_t<decltype(s)> SHAPE;
+      return s.SHAPE::intersect(ray, t);
+    }, shape);
+  }
+
+
+  template <typename T>
+  inline void rotate3D(ShapeVariant<T>& shape, T angle, const Eigen::Matrix<T, 3, 1>& axis){
+    std::visit([&](auto& s){
+      typedef std::decay_t<decltype(s)> SHAPE;
+      s.SHAPE::rotate3D(angle, axis);
+    }, shape);
+  }
+
+
+  template <typename T>
+  inline void transform(ShapeVariant<T>& shape, const Eigen::Transform<T, 3, Eigen::Affine>& matrix){
+    asShape(shape).transform(matrix);
+  }
+
+} // namespace geo
+
+
+#endif // SHAPE_VARIANT_H
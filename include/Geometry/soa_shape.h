@@ -0,0 +1,247 @@
+#ifndef SOA_SHAPE_H
+#define SOA_SHAPE_H
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+#include "shape.h"
+#include "executor.h"
+
+namespace geo {
+
+  /** CLASS SoAShape
+    * Template params:
+    *                 T --> type used for the coordinates
+    *                 DIM --> Number of dimensions
+    *                 LANES --> Number of vertices per block (8 for AVX2 and 16 for AVX-512 with floats)
+    *
+    * Vertices and normals of a shape stored in blocks of LANES vertices (AoSoA layout): each block holds LANES X coordinates, then LANES Y coordinates, and so on.
+    * Transformations and normal renormalization then run over full SIMD registers instead of one vertex at a time.
+    * The last block is padded with zeros.
+    * data() and normalsData() still provide the packed interleaved layout of Shape (x0, y0, z0, x1, ...), rebuilt on demand after a transformation.
+    * As with Shape, const member functions can be called from several threads at once: the rebuild is done by one of them.
+    */
+
+  template <typename T = float, uint8_t DIM = 3, size_t LANES = 8>
+  class SoAShape {
+  public:
+    typedef Eigen::Array<T, LANES, DIM> Block;
+
+  private:
+    size_t _size {0};
+    size_t _normals_size {0};
+
+    std::vector<Block, Eigen::aligned_allocator<Block>> _vertices;
+    std::vector<Block, Eigen::aligned_allocator<Block>> _normals;
+
+    // Packed copies of vertices and normals, valid while _packed is set
+    mutable std::atomic<bool> _packed {false};
+    mutable std::vector<T> _packed_vertices;
+    mutable std::vector<T> _packed_normals;
+
+    // Serializes the rebuilds of the packed copies made by const member functions
+    mutable std::mutex _mutex;
+
+    template <typename InputIterator>
+    static void toBlocks(InputIterator first, size_t count, std::vector<Block, Eigen::aligned_allocator<Block>>& blocks) {
+      blocks.assign((count + LANES - 1) / LANES, Block::Zero());
+      for(size_t i = 0; i < count; i++, ++first)
+        for(uint8_t j = 0; j < DIM; j++)
+          blocks[i / LANES](i % LANES, j) = (*first)[j];
+    }
+
+    // Copies the state of "s", locked against a concurrent rebuild of its packed copies
+    void copy(const SoAShape& s) {
+      std::lock_guard<std::mutex> lock(s._mutex);
+
+      _size = s._size;
+      _normals_size = s._normals_size;
+      _vertices = s._vertices;
+      _normals = s._normals;
+      _packed = s._packed.load();
+      _packed_vertices = s._packed_vertices;
+      _packed_normals = s._packed_normals;
+    }
+
+    static void toPacked(const std::vector<Block, Eigen::aligned_allocator<Block>>& blocks, size_t count, std::vector<T>& packed) {
+      packed.resize(count * DIM);
+      for(size_t i = 0; i < count; i++)
+        for(uint8_t j = 0; j < DIM; j++)
+          packed[i * DIM + j] = blocks[i / LANES](i % LANES, j);
+    }
+
+    /**
+      * SIMD kernel: each output coordinate is computed for the LANES vertices of the block at once
+      */
+    static void transformBlock(Block& block, const Eigen::Matrix<T, DIM, DIM>& linear, const Eigen::Matrix<T, DIM, 1>& translation) {
+      Block result;
+      for(uint8_t i = 0; i < DIM; i++){
+        result.col(i) = block.col(0) * linear(i, 0) + translation[i];
+        for(uint8_t j = 1; j < DIM; j++)
+          result.col(i) += block.col(j) * linear(i, j);
+      }
+      block = result;
+    }
+
+    /**
+      * SIMD kernel: normalizes the LANES vectors of the block at once (padding vectors are left untouched)
+      */
+    static void normalizeBlock(Block& block) {
+      Eigen::Array<T, LANES, 1> norm = block.square().rowwise().sum().sqrt();
+      norm = (norm > static_cast<T>(0)).select(norm, Eigen::Array<T, LANES, 1>::Ones());
+      block.colwise() /= norm;
+    }
+
+  public:
+    SoAShape() {}
+
+    SoAShape(const Shape<T, DIM>& shape) : _size{shape.vertices().size()}, _normals_size{shape.normals().size()} {
+      toBlocks(shape.vertices().begin(), _size, _vertices);
+      toBlocks(shape.normals().begin(), _normals_size, _normals);
+    }
+
+    SoAShape(const SoAShape& s) { copy(s); }
+
+    SoAShape(SoAShape&& s) noexcept : _size{s._size}, _normals_size{s._normals_size}, _vertices{std::move(s._vertices)}, _normals{std::move(s._normals)},
+                                      _packed{s._packed.load()}, _packed_vertices{std::move(s._packed_vertices)}, _packed_normals{std::move(s._packed_normals)} {}
+
+    SoAShape& operator=(const SoAShape& s) {
+      if (this != &s) copy(s);
+      return *this;
+    }
+
+    SoAShape& operator=(SoAShape&& s) {
+      _size = s._size;
+      _normals_size = s._normals_size;
+      _vertices = std::move(s._vertices);
+      _normals = std::move(s._normals);
+      _packed = s._packed.load();
+      _packed_vertices = std::move(s._packed_vertices);
+      _packed_normals = std::move(s._packed_normals);
+      return *this;
+    }
+
+    ~SoAShape() {}
+
+    size_t size() const { return _size; }
+
+    size_t blocks() const { return _vertices.size(); }
+
+    const Block& block(size_t pos) const { return _vertices.at(pos); }
+    const Block& normalsBlock(size_t pos) const { return _normals.at(pos); }
+
+    Point<T, DIM> vertex(size_t pos) const {
+      Point<T, DIM> p;
+      for(uint8_t j = 0; j < DIM; j++)
+        p[j] = _vertices.at(pos / LANES)(pos % LANES, j);
+      return p;
+    }
+
+    Eigen::Matrix<T, DIM, 1> normal(size_t pos) const {
+      Eigen::Matrix<T, DIM, 1> n;
+      for(uint8_t j = 0; j < DIM; j++)
+        n[j] = _normals.at(pos / LANES)(pos % LANES, j);
+      return n;
+    }
+
+    const T* data() const {
+      pack();
+      return _packed_vertices.data();
+    }
+
+    const T* normalsData() const {
+      pack();
+      return _packed_normals.data();
+    }
+
+    /**
+      * Rebuilds the packed interleaved copies of vertices and normals, if a transformation has invalidated them
+      */
+    void pack() const {
+      if (_packed) return;
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_packed) return;
+
+      toPacked(_vertices, _size, _packed_vertices);
+      toPacked(_normals, _normals_size, _packed_normals);
+      _packed = true;
+    }
+
+    /**
+      * Affine transformation: vertices are transformed with the matrix and normals with its inverse-transpose (and renormalized)
+      */
+    void transform(const Eigen::Transform<T, DIM, Eigen::Affine>& matrix) {
+      GEO_SCOPED_TIMER(TRANSFORM_PASS);
+      GEO_COUNT(VERTICES_PROCESSED, _size);
+
+      Eigen::Matrix<T, DIM, DIM> linear = matrix.linear();
+      Eigen::Matrix<T, DIM, 1> translation = matrix.translation();
+      for(Block& block : _vertices)
+        transformBlock(block, linear, translation);
+
+      Eigen::Matrix<T, DIM, DIM> normal_matrix = linear.inverse().transpose();
+      for(Block& block : _normals){
+        transformBlock(block, normal_matrix, Eigen::Matrix<T, DIM, 1>::Zero());
+        normalizeBlock(block);
+      }
+
+      _packed = false;
+    }
+
+    /**
+      * Same as above, with the blocks split across the threads of the executor
+      */
+    void transform(const Eigen::Transform<T, DIM, Eigen::Affine>& matrix, const Executor& executor) {
+      GEO_SCOPED_TIMER(TRANSFORM_PASS);
+      GEO_COUNT(VERTICES_PROCESSED, _size);
+
+      Eigen::Matrix<T, DIM, DIM> linear = matrix.linear();
+      Eigen::Matrix<T, DIM, 1> translation = matrix.translation();
+      executor.parallelFor(_vertices.size(), [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++)
+          transformBlock(_vertices[i], linear, translation);
+      }, LANES);
+
+      Eigen::Matrix<T, DIM, DIM> normal_matrix = linear.inverse().transpose();
+      executor.parallelFor(_normals.size(), [&](size_t first, size_t last){
+        for(size_t i = first; i < last; i++){
+          transformBlock(_normals[i], normal_matrix, Eigen::Matrix<T, DIM, 1>::Zero());
+          normalizeBlock(_normals[i]);
+        }
+      }, LANES);
+
+      _packed = false;
+    }
+
+    void scale3D(T scale){
+      scale3D(scale, scale, scale);
+    }
+
+    void scale3D(T scale_X, T scale_Y, T scale_Z){
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::Scaling(scale_X, scale_Y, scale_Z)));
+    }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis) {
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::AngleAxis<T>(angle, axis)));
+    }
+
+    void scale3D(T scale, const Executor& executor){
+      scale3D(scale, scale, scale, executor);
+    }
+
+    void scale3D(T scale_X, T scale_Y, T scale_Z, const Executor& executor){
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::Scaling(scale_X, scale_Y, scale_Z)), executor);
+    }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis, const Executor& executor) {
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::AngleAxis<T>(angle, axis)), executor);
+    }
+  }; // class SoAShape
+
+} // namespace geo
+
+
+#endif // SOA_SHAPE_H
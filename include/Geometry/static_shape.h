@@ -0,0 +1,62 @@
+#ifndef STATIC_SHAPE_H
+#define STATIC_SHAPE_H
+
+#include <array>
+
+#include "point.h"
+#include "transformations.h"
+
+namespace geo {
+
+  /** CLASS StaticShape
+    * Template params:
+    *                 T --> type used for the coordinates
+    *                 DIM --> Number of dimensions
+    *                 NUM_VERTICES --> Number of vertices
+    *                 NUM_NORMALS --> Number of normals
+    *
+    * Fixed-size counterpart of Shape: vertices and normals are stored by value in std::arrays, so creating one costs no heap allocation and
+    * instances can be stored by value in large arrays. There are no virtual functions: transformations are resolved at compile time.
+    */
+
+  template <typename T, uint8_t DIM, size_t NUM_VERTICES, size_t NUM_NORMALS>
+  class StaticShape{
+
+  protected:
+    std::array<Point<T, DIM>, NUM_VERTICES> _vertices;
+
+    std::array<Eigen::Matrix<T, DIM, 1>, NUM_NORMALS> _normals;
+
+  public:
+    static constexpr size_t size() { return NUM_VERTICES; }
+
+    const std::array<Point<T, DIM>, NUM_VERTICES> & vertices() const { return this->_vertices; }
+    const T* data() const { return this->_vertices.data()->data(); }
+
+    const std::array<Eigen::Matrix<T, DIM, 1>, NUM_NORMALS> & normals() const { return this->_normals; }
+    const T* normalsData() const { return this->_normals.data()->data(); }
+
+    const Point<T, DIM>& operator[](size_t pos) const { return _vertices.at(pos); }
+
+    void transform(const Eigen::Transform<T, DIM, Eigen::Affine>& matrix){
+      transformPoints(matrix, _vertices.data(), _vertices.data() + NUM_VERTICES);
+      transformNormals(Eigen::Matrix<T, DIM, DIM>(matrix.linear().inverse().transpose()), _normals.data(), _normals.data() + NUM_NORMALS);
+    }
+
+    void scale3D(T scale){
+      scale3D(scale, scale, scale);
+    }
+
+    void scale3D(T scale_X, T scale_Y, T scale_Z){
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::Scaling(scale_X, scale_Y, scale_Z)));
+    }
+
+    void rotate3D(T angle, const Eigen::Matrix<T, 3, 1> & axis) {
+      transform(Eigen::Transform<T, 3, Eigen::Affine>(Eigen::AngleAxis<T>(angle, axis)));
+    }
+  }; // class StaticShape
+
+} // namespace geo
+
+
+#endif // STATIC_SHAPE_H
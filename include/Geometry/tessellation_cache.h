@@ -0,0 +1,218 @@
+#ifndef TESSELLATION_CACHE_H
+#define TESSELLATION_CACHE_H
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+
+#include "shape.h"
+
+#define DEF_MEMORY_LIMIT (64 << 20)
+
+namespace geo {
+
+  /** STRUCT Tessellation
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * Immutable vertices and normals of a shape in its local space, shared by all its instances
+    */
+
+  template <typename T = float>
+  struct Tessellation {
+    std::vector<Point<T, 3>> vertices;
+    std::vector<Eigen::Matrix<T, 3, 1>> normals;
+    Eigen::AlignedBox<T, 3> aabb;
+    BoundingSphere<T, 3> sphere;
+
+    Tessellation(const Shape<T, 3>& shape) : vertices(shape.vertices().begin(), shape.vertices().end()),
+                                             normals(shape.normals().begin(), shape.normals().end()), aabb{shape.aabb()}, sphere{shape.boundingSphere()} {}
+
+    size_t size() const { return vertices.size(); }
+
+    // Approximate memory used by the vertices and normals
+    size_t bytes() const { return vertices.capacity() * sizeof(Point<T, 3>) + normals.capacity() * sizeof(Eigen::Matrix<T, 3, 1>); }
+  };
+
+
+  /**
+    * Constructor parameters which can be part of the keys of the TessellationCache: numbers, and points or vectors of numbers
+    */
+  template <typename ARG>
+  struct IsKeyParameter : std::is_arithmetic<ARG> {};
+
+  template <typename S, uint8_t DIM>
+  struct IsKeyParameter<Point<S, DIM>> : std::is_arithmetic<S> {};
+
+  template <typename S, int ROWS, int OPTIONS, int MAX_ROWS, int MAX_COLS>
+  struct IsKeyParameter<Eigen::Matrix<S, ROWS, 1, OPTIONS, MAX_ROWS, MAX_COLS>> : std::is_arithmetic<S> {};
+
+
+  /** CLASS TessellationCache
+    * Template params:
+    *                 T --> type used for the coordinates
+    *
+    * Thread-safe cache of tessellations, keyed on the shape type and its constructor parameters (numbers and points, see IsKeyParameter).
+    * Parameters are normalized before being added to the key: integers of any type as 64-bit integers, and floating point values as doubles
+    * (with -0.0 as 0.0 and a single NaN), so the same value passed with different integer or floating point types gives the same key
+    * (integers and floating point values are still kept apart).
+    * When the tessellations held by the cache exceed the memory limit, the least recently used ones are evicted. Evicted tessellations stay alive
+    * while they are in use, but are not shared anymore with new requests.
+    * Parameters:
+    *            - memory_limit: bytes of vertices and normals held by the cache (default = 64 MB)
+    */
+
+  template <typename T = float>
+  class TessellationCache {
+    typedef std::shared_ptr<const Tessellation<T>> Entry;
+    typedef std::list<std::pair<std::string, Entry>> LRUList;
+
+    mutable std::mutex _mutex;
+
+    size_t _memory_limit;
+    size_t _bytes {0};
+
+    // Most recently used first
+    LRUList _lru;
+    std::unordered_map<std::string, typename LRUList::iterator> _entries;
+
+    size_t _hits {0};
+    size_t _misses {0};
+    size_t _evictions {0};
+
+    template <typename VALUE>
+    static void appendBytes(std::string& key, VALUE value) { key.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+
+    // Tag of the kind of parameter, followed by its normalized value
+    template <typename ARG>
+    static void appendParameter(std::string& key, const ARG& arg) {
+      if constexpr (std::is_integral_v<ARG>){
+        key += 'i';
+        appendBytes(key, static_cast<uint64_t>(arg));
+      }
+      else if constexpr (std::is_floating_point_v<ARG>){
+        double value {static_cast<double>(arg)};
+        if (value == 0) value = 0;
+        if (std::isnan(value)) value = std::numeric_limits<double>::quiet_NaN();
+
+        key += 'f';
+        appendBytes(key, value);
+      }
+      else{
+        key += 'p';
+        appendBytes(key, static_cast<uint64_t>(arg.size()));
+        for(Eigen::Index i = 0; i < arg.size(); i++)
+          appendParameter(key, arg[i]);
+      }
+    }
+
+    template <typename... ARGS>
+    static std::string key(const std::type_info& type, const ARGS&... args) {
+      static_assert((IsKeyParameter<ARGS>::value && ...), "Tessellations can only be cached for parameters which are numbers or points.");
+
+      std::string key {type.name()};
+      (appendParameter(key, args), ...);
+
+      return key;
+    }
+
+    // The mutex must be locked
+    void evict() {
+      while(_bytes > _memory_limit && !_lru.empty()){
+        _bytes -= _lru.back().second->bytes();
+        _entries.erase(_lru.back().first);
+        _lru.pop_back();
+        _evictions++;
+      }
+    }
+
+  public:
+    TessellationCache(size_t memory_limit = DEF_MEMORY_LIMIT) : _memory_limit{memory_limit} {}
+
+    TessellationCache(const TessellationCache&) = delete;
+    TessellationCache& operator=(const TessellationCache&) = delete;
+
+    ~TessellationCache() {}
+
+    /**
+      * Cache shared by default (by ShapeInstance::create)
+      */
+    static TessellationCache& global() {
+      static TessellationCache cache;
+      return cache;
+    }
+
+    /**
+      * Tessellation of SHAPE(args...), built on a miss (outside the lock: other threads are not blocked meanwhile)
+      */
+    template <typename SHAPE, typename... ARGS>
+    Entry get(const ARGS&... args) {
+      std::string k = key(typeid(SHAPE), args...);
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _entries.find(k);
+        if (it != _entries.end()){
+          _hits++;
+          _lru.splice(_lru.begin(), _lru, it->second);
+          return it->second->second;
+        }
+        _misses++;
+      }
+
+      Entry tessellation = std::make_shared<const Tessellation<T>>(SHAPE(args...));
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto it = _entries.find(k);
+      if (it != _entries.end()){
+        // Built at the same time by another thread: its entry is used (this call stays counted as a miss, it did build the shape)
+        _lru.splice(_lru.begin(), _lru, it->second);
+        return it->second->second;
+      }
+
+      _lru.emplace_front(k, tessellation);
+      _entries.emplace(std::move(k), _lru.begin());
+      _bytes += tessellation->bytes();
+      evict();
+
+      return tessellation;
+    }
+
+    void setMemoryLimit(size_t memory_limit) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _memory_limit = memory_limit;
+      evict();
+    }
+
+    void clear() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _lru.clear();
+      _entries.clear();
+      _bytes = 0;
+    }
+
+    size_t memoryLimit() const { std::lock_guard<std::mutex> lock(_mutex); return _memory_limit; }
+    size_t bytes() const { std::lock_guard<std::mutex> lock(_mutex); return _bytes; }
+    size_t size() const { std::lock_guard<std::mutex> lock(_mutex); return _entries.size(); }
+
+    size_t hits() const { std::lock_guard<std::mutex> lock(_mutex); return _hits; }
+    size_t misses() const { std::lock_guard<std::mutex> lock(_mutex); return _misses; }
+    size_t evictions() const { std::lock_guard<std::mutex> lock(_mutex); return _evictions; }
+
+    void resetCounters() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _hits = _misses = _evictions = 0;
+    }
+  }; // class TessellationCache
+
+} // namespace geo
+
+#undef DEF_MEMORY_LIMIT
+
+#endif // TESSELLATION_CACHE_H
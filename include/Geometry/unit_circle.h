@@ -0,0 +1,84 @@
+#ifndef UNIT_CIRCLE_H
+#define UNIT_CIRCLE_H
+
+#include <array>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cmath>
+
+#include <Eigen/Geometry>
+
+#include "constants.h"
+
+namespace geo {
+
+  /**
+    * Returns the "num_vertices" points of the unit circle, starting at (1, 0) and going anticlockwise: point i = (cos(i * 2PI/num_vertices), sin(i * 2PI/num_vertices)).
+    * The table is computed (in double precision) the first time a number of vertices is requested, and shared afterwards by all the round shapes.
+    * Tables are never released, so the returned reference remains valid. Thread-safe.
+    */
+  template <typename T>
+  const std::vector<Eigen::Matrix<T, 2, 1>> & unitCircle(size_t num_vertices) {
+    static std::mutex mutex;
+    static std::map<size_t, std::vector<Eigen::Matrix<T, 2, 1>>> tables;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    typename std::map<size_t, std::vector<Eigen::Matrix<T, 2, 1>>>::iterator it = tables.find(num_vertices);
+    if (it == tables.end()){
+      std::vector<Eigen::Matrix<T, 2, 1>> table(num_vertices);
+      double delta_angle = _2PI_ / num_vertices;
+      for(size_t i = 0; i < num_vertices; i++)
+        table[i] = Eigen::Matrix<T, 2, 1>(static_cast<T>(std::cos(delta_angle * i)), static_cast<T>(std::sin(delta_angle * i)));
+
+      it = tables.emplace(num_vertices, std::move(table)).first;
+    }
+
+    return it->second;
+  }
+
+
+  /**
+    * Compile-time cosine and sine (Taylor series, after reducing the angle to [-PI, PI])
+    */
+  constexpr double staticCos(double angle) {
+    while(angle > _PI_) angle -= _2PI_;
+    while(angle < -_PI_) angle += _2PI_;
+
+    double term {1}, sum {1};
+    for(int i = 1; i < 30; i++){
+      term *= -angle * angle / ((2 * i - 1) * (2 * i));
+      sum += term;
+    }
+    return sum;
+  }
+
+  constexpr double staticSin(double angle) {
+    while(angle > _PI_) angle -= _2PI_;
+    while(angle < -_PI_) angle += _2PI_;
+
+    double term {angle}, sum {angle};
+    for(int i = 1; i < 30; i++){
+      term *= -angle * angle / ((2 * i) * (2 * i + 1));
+      sum += term;
+    }
+    return sum;
+  }
+
+  /**
+    * Compile-time version of unitCircle: the N points of the unit circle as (cos, sin) pairs, packed in one array
+    */
+  template <typename T, size_t N>
+  constexpr std::array<T, 2 * N> staticUnitCircle() {
+    std::array<T, 2 * N> table {};
+    for(size_t i = 0; i < N; i++){
+      table[2 * i] = static_cast<T>(staticCos(_2PI_ * i / N));
+      table[2 * i + 1] = static_cast<T>(staticSin(_2PI_ * i / N));
+    }
+    return table;
+  }
+
+} // namespace geo
+
+
+#endif // UNIT_CIRCLE_H